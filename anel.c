@@ -0,0 +1,76 @@
+/**
+ * @file    anel.c
+ * @brief   Arquivo responsável pela implementação do anel de um produtor e um consumidor e de suas funções de criação,
+ * manipulação e liberação.
+ * @author  Daniel Corona de Aguiar (daniel.aguiar@edu.ufes.br/2023101578)
+ * @author  João Pedro Pereira Loss (joao.loss@edu.ufes.br/2023102068)
+ * @author  Raphael Correia Dornelas (raphael.dornelas@edu.ufes.br/2023100595)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "anel.h"
+
+#define TAM_LINHA_CACHE 64
+
+struct _anel {
+    // os índices crescem sem parar e são reduzidos à posição do slot com a máscara; cada um fica na sua própria linha de
+    // cache para que produtor e consumidor não disputem a mesma linha a cada operação
+    _Alignas(TAM_LINHA_CACHE) atomic_size_t inicio; // escrito apenas pelo consumidor
+    _Alignas(TAM_LINHA_CACHE) atomic_size_t fim; // escrito apenas pelo produtor
+
+    _Alignas(TAM_LINHA_CACHE) size_t mascara;
+    int tamElemento;
+    unsigned char* elementos;
+};
+
+Anel* criaAnel(int capacidade, int tamElemento) {
+    if(capacidade <= 0 || tamElemento <= 0) return NULL;
+
+    size_t numSlots = 1;
+    while(numSlots < (size_t)capacidade) numSlots <<= 1;
+
+    // aligned_alloc exige tamanho múltiplo do alinhamento
+    size_t tamAnel = (sizeof(Anel) + TAM_LINHA_CACHE - 1) / TAM_LINHA_CACHE * TAM_LINHA_CACHE;
+    Anel* a = aligned_alloc(TAM_LINHA_CACHE, tamAnel);
+    atomic_init(&a->inicio, 0);
+    atomic_init(&a->fim, 0);
+    a->mascara = numSlots - 1;
+    a->tamElemento = tamElemento;
+    a->elementos = malloc(numSlots * tamElemento);
+
+    return a;
+}
+
+int insereAnel(Anel* a, const void* elemento) {
+    size_t fim = atomic_load_explicit(&a->fim, memory_order_relaxed);
+    size_t inicio = atomic_load_explicit(&a->inicio, memory_order_acquire);
+    if(fim - inicio > a->mascara) return 0;
+
+    memcpy(a->elementos + (fim & a->mascara) * a->tamElemento, elemento, a->tamElemento);
+
+    // a liberação publica o elemento copiado antes do novo fim
+    atomic_store_explicit(&a->fim, fim + 1, memory_order_release);
+    return 1;
+}
+
+int retiraAnel(Anel* a, void* elemento) {
+    size_t inicio = atomic_load_explicit(&a->inicio, memory_order_relaxed);
+    size_t fim = atomic_load_explicit(&a->fim, memory_order_acquire);
+    if(inicio == fim) return 0;
+
+    memcpy(elemento, a->elementos + (inicio & a->mascara) * a->tamElemento, a->tamElemento);
+
+    // só depois da cópia o slot é devolvido ao produtor
+    atomic_store_explicit(&a->inicio, inicio + 1, memory_order_release);
+    return 1;
+}
+
+void liberaAnel(Anel* a) {
+    if(a == NULL) return;
+
+    free(a->elementos);
+    free(a);
+}
@@ -0,0 +1,40 @@
+/**
+ * @file    anel.h
+ * @brief   Arquivo responsável pela definição da interface com o cliente do anel (buffer circular) de um produtor e um
+ * consumidor.
+ * @author  Daniel Corona de Aguiar (daniel.aguiar@edu.ufes.br/2023101578)
+ * @author  João Pedro Pereira Loss (joao.loss@edu.ufes.br/2023102068)
+ * @author  Raphael Correia Dornelas (raphael.dornelas@edu.ufes.br/2023100595)
+ */
+
+#ifndef ANEL_H
+#define ANEL_H
+
+/// @brief TAD opaco responsável por um buffer circular de capacidade fixa, sem travas, para exatamente uma thread
+/// produtora e uma thread consumidora. Os elementos têm todos o mesmo tamanho e são copiados para dentro e para fora do
+/// anel. Nenhuma das operações bloqueia: cabe a quem as chama decidir como esperar.
+typedef struct _anel Anel;
+
+/// @brief Cria um anel vazio.
+/// @param capacidade Número mínimo de elementos comportados (arredondado para a próxima potência de 2)
+/// @param tamElemento Tamanho, em bytes, de cada elemento
+/// @return Ponteiro para o anel alocado dinamicamente ou NULL se os parâmetros forem inválidos.
+Anel* criaAnel(int capacidade, int tamElemento);
+
+/// @brief Copia um elemento para o fim do anel. Deve ser chamada apenas pela thread produtora.
+/// @param a Ponteiro para o anel
+/// @param elemento Ponteiro para o elemento a ser copiado
+/// @return 1 se o elemento foi inserido e 0 se o anel estiver cheio.
+int insereAnel(Anel* a, const void* elemento);
+
+/// @brief Copia o primeiro elemento do anel e o retira. Deve ser chamada apenas pela thread consumidora.
+/// @param a Ponteiro para o anel
+/// @param elemento Ponteiro para o local onde o elemento deve ser copiado
+/// @return 1 se um elemento foi retirado e 0 se o anel estiver vazio.
+int retiraAnel(Anel* a, void* elemento);
+
+/// @brief Libera toda a memória utilizada pelo anel, incluindo os elementos restantes.
+/// @param a Ponteiro para o anel
+void liberaAnel(Anel* a);
+
+#endif
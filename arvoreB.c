@@ -8,12 +8,29 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "arvoreB.h"
 #include "fila.h"
+#include "logValores.h"
+#include "filtro.h"
 
 #define NOME_ARQ_BIN "arvB.bin"
+#define EXTENSAO_LOG ".vlog"
+#define EXTENSAO_TEMPORARIO ".tmp"
+#define EXTENSAO_FILTRO ".filtro"
 #define POSICAO_RAIZ 0
+#define MAGICO_RETRATO 0x42767241 // "ArvB" no início de todo retrato de salvaArvB
+#define VERSAO_RETRATO 1
+#define TAM_CABECALHO_RETRATO 8 // mágico, versão, ordem, numNos, offsetAcumulado, capacidadeBuffer, temFiltro, numSlotsLivres
+#define ORDEM_MINIMA 3
+#define TAM_LINHA_CACHE 64
+#define CAPACIDADE_INICIAL_ARENA 16
+#define REGISTRO_APAGADO INT_MIN // registro de uma chave removida em modo bufferizado (e da mensagem que a remove);
+                                 // por isso, é um valor reservado e não aceito como registro nesse modo
 #define TRUE 1
 #define FALSE 0
 
@@ -41,36 +58,167 @@ struct _node {
     int* filhos; 
     // sempre igual ao número de chaves armazenadas + 1
     // indica o offset (deslocamento) necessário para encontrar os filhos no arq. bin.
+
+    int* contagens;
+    // contagens[i] é o número de chaves da subárvore de filhos[i] (não utilizado em folhas)
+
+    int* pendentes;
+    // modo bufferizado: pendentes[i] é o número de mensagens nos buffers da subárvore de filhos[i] (não utilizado em
+    // folhas); a consolidação só desce pelos filhos com mensagens pendentes
+
+    int numMensagens;
+    int* chavesBuffer;
+    int* registrosBuffer;
+    // mensagens pendentes (modo bufferizado, apenas nós internos), ordenadas por chave e no máximo uma por chave;
+    // são mais recentes que tudo o que está abaixo do nó, inclusive as suas próprias chaves
+
+    Node* proxLivre; // próximo nó da lista de nós livres da árvore (válido apenas enquanto o nó está livre)
+
+    // 'chaves', 'registros', 'filhos', 'contagens', 'pendentes' e o buffer apontam para o espaço alocado logo após a estrutura, no mesmo bloco
 };
 
+/// @brief Vetor dinâmico de chaves, usado para registrar as chaves apagadas até a consolidação.
+typedef struct {
+    int* chaves;
+    int num;
+    int capacidade;
+} VetorChaves;
+
 struct _arvB {
     int ordem;
     int numNos;
-    int nodeSizeBytes;
+    int nodeSizeBytes; // tamanho do slot de cada nó no arq. bin. (igual à página quando criada por tamanho de página)
     int offsetAcumulado;
+    int* slotsLivres; // posições de nós descartados, reaproveitadas antes de o arq. bin. (ou a arena) crescer
+    int numSlotsLivres;
+    int capacidadeSlotsLivres;
+    int tamPagina; // tamanho de página do qual a ordem foi derivada (0 se a ordem foi fornecida)
+    char* nomeArqBin;
     FILE* arqBin;
+    unsigned char* pagina; // página auxiliar para ler/escrever um nó do arq. bin. de uma só vez
+    char acessoDireto; // 1: cada página lida ou gravada vai ao dispositivo, sem ficar no cache do sistema (medições)
+    LogValores* logValores; // criado na primeira inserção de valor em bytes; os registros passam a ser deslocamentos no log
+
+    char emMemoria;
+    // 1: nós mantidos na arena (sem arq. bin.) | 0: nós mantidos no arq. bin.
+    unsigned char* arena; // slots de 'nodeSizeBytes' bytes, alinhados à linha de cache e endereçados pela posição do nó
+    int capacidadeArena; // em número de nós
+
+    Node* nodesLivres; // blocos de nós já alocados e reaproveitados por criaNode, evitando alocações a cada operação
+
+    Filtro* filtro; // filtro de pertinência consultado antes de cada busca (NULL se desabilitado)
+    long consultasFiltro;
+    long negativasFiltro; // buscas encerradas pelo filtro sem acessar nenhum nó
+    long falsosPositivosFiltro; // buscas liberadas pelo filtro cuja chave não estava na árvore
+
+    int capacidadeBuffer; // mensagens por nó interno (0: modo bufferizado desabilitado)
+    unsigned char* paginaRaiz; // modo bufferizado em arquivo: página da raíz, reescrita a cada mensagem, mantida na memória
+    char bufferConsolidado; // 1: nenhuma mensagem pendente nem chave apagada desde a última consolidação
+    VetorChaves apagadas; // chaves marcadas como apagadas nos nós desde a última consolidação (pode ter repetições)
+    char apagadasDesconhecidas; // 1: árvore recarregada de um retrato; a consolidação procura as chaves apagadas
 };
 
+/// @brief Operações sobre o registro de uma chave feitas em uma única descida (ver executaOperacao).
+typedef enum {
+    ATRIBUICAO, // insere a chave ou substitui o seu registro
+    INSERCAO_SE_AUSENTE, // insere a chave apenas se ela não estiver na árvore
+    COMPARACAO_TROCA, // substitui o registro apenas se ele for igual a 'esperado'; nunca insere
+    ACUMULO // soma 'registro' ao registro da chave ou insere a chave com 'registro'
+} TipoOperacao;
+
+typedef struct {
+    TipoOperacao tipo;
+    int registro;
+    int esperado;
+    int registroMinimo; // menor registro permitido: INT_MIN + 1 no modo bufferizado (REGISTRO_APAGADO é reservado)
+
+    int encontrada; // a chave já estava na árvore
+    int anterior; // registro antes da operação (se encontrada)
+    int resultado; // registro depois da operação (se a chave estiver na árvore ao final)
+} Operacao;
+
+/// @brief Subárvore resultante de um corte ou de uma junção na remoção por intervalo: posição da sua raíz, altura (-1 se
+/// vazia, 0 se a raíz for folha) e número de chaves. A raíz pode ter menos chaves que o mínimo de um nó interno.
+typedef struct {
+    int posicao;
+    int altura;
+    int numChaves;
+} Subarvore;
+
 // --- FUNÇÕES DE INTERFACE
 ArvB* criaArvB(int ordem);
+ArvB* criaArvBPagina(int tamPaginaBytes);
+ArvB* criaArvBMemoria(int ordem);
+int salvaArvB(ArvB* arv, const char* nomeArq);
+ArvB* carregaArvB(const char* nomeArq);
+int ordemPorTamPagina(int tamPaginaBytes);
+int defineArqBinArvB(ArvB* arv, const char* nomeArqBin);
+int defineAcessoDiretoArvB(ArvB* arv, int acessoDireto);
+int getOrdemArvB(ArvB* arv);
+int habilitaFiltroArvB(ArvB* arv, int numChavesEsperadas, double taxaFalsoPositivo);
+int habilitaBufferArvB(ArvB* arv, int capacidadeBuffer);
+void descarregaBuffersArvB(ArvB* arv);
+void estatisticasFiltroArvB(ArvB* arv, long* consultas, long* negativas, long* falsosPositivos);
 void insereChaveValor(ArvB* arv, int chave, int registro);
 int buscaChave(ArvB* arv, int chave, int* registroBuscado);
+int insereChaveBytes(ArvB* arv, int chave, const void* valor, int tamValor);
+int buscaChaveBytes(ArvB* arv, int chave, void* valor, int tamMax);
+int compactaLogValores(ArvB* arv);
 void imprimeArvB(ArvB* arv, FILE* saida);
 void removeChaveValor(ArvB* arv, int chave);
+int insereSeAusente(ArvB* arv, int chave, int registro, int* registroExistente);
+int comparaETroca(ArvB* arv, int chave, int esperado, int novo, int* registroAtual);
+int acumulaRegistro(ArvB* arv, int chave, int incremento);
+int removeERetorna(ArvB* arv, int chave, int* registroRemovido);
+int removeIntervalo(ArvB* arv, int chaveMin, int chaveMax);
+void percorreIntervalo(ArvB* arv, int chaveMin, int chaveMax, VisitaChave visita, void* contexto);
+int rankChave(ArvB* arv, int chave);
+int selecionaK(ArvB* arv, int k, int* chave, int* registro);
+int contaIntervalo(ArvB* arv, int chaveMin, int chaveMax);
 void liberaArvB(ArvB* arv);
 // ---
 
 // --- FUNÇÕES INTERNAS
-static Node* criaNode(int ordem, char ehFolha, int posicaoArqBin);
-static void liberaNode(Node* n);
+static Node* criaNode(ArvB* arv, char ehFolha, int posicaoArqBin);
+static void liberaNode(ArvB* arv, Node* n);
 
 static int arvBVazia(ArvB* arv);
+static int consultaFiltroArvB(ArvB* arv, int chave);
+static int tamNodeBytes(int ordem);
+static int tamNodeBytesArv(ArvB* arv);
+static int tamBufferBytes(int ordem, int capacidadeBuffer);
+static int tamNodeBytesTransferidos(ArvB* arv, char ehFolha);
+static void liberaNodesLivres(ArvB* arv);
+static char* nomeArqDerivado(const char* nomeArq, const char* extensao);
 static int cheio(Node* n, int ordem);
 static int buscaBinaria(int c, int* chaves, int inicio, int fim);
+static void garanteCapacidadeArena(ArvB* arv, int numSlots);
+static int alocaSlot(ArvB* arv);
+static void liberaSlot(ArvB* arv, int posicao);
+static unsigned char* lePagina(ArvB* arv, int offset);
+static void descartaCachePagina(ArvB* arv, int offset, int sincroniza);
 static Node* leNodeArqBin(int offset, ArvB* arv);
 static void escreveNodeArqBin(ArvB* arv, Node* n);
 static int buscaChaveNode(ArvB* arv, int posNode, int chave, int* registroBuscado);
-static void insereChaveValorRec(ArvB* arv, Node* n, int chave, int registro);
+static void percorreIntervaloRec(ArvB* arv, int posNode, int chaveMin, int chaveMax, VisitaChave visita, void* contexto);
+static int totalChavesNode(Node* n);
+static int contaMenores(ArvB* arv, int chave, int* encontrada);
+static int aplicaOperacao(Operacao* op, int* registro);
+static int operacaoInsere(Operacao* op);
+static void executaOperacao(ArvB* arv, int chave, Operacao* op);
+static int insereChaveValorRec(ArvB* arv, Node* n, int chave, Operacao* op);
+static void splitRaiz(ArvB* arv, Node* raiz);
+static int registroVivo(ArvB* arv, int registro, int* registroBuscado);
+static int registroReservado(ArvB* arv, int registro);
+static void insereMensagem(ArvB* arv, int chave, int registro);
+static int registraMensagem(ArvB* arv, Node* n, int chave, int registro);
+static int aplicaMensagemFolha(ArvB* arv, Node* folha, int chave, int registro);
+static int aplicaLoteNode(ArvB* arv, Node* n, int* chaves, int* registros, int num, int* novas);
+static int aplicaLoteFilhos(ArvB* arv, Node* n, int* chaves, int* registros, int num, int* novas);
+static int descarregaBuffer(ArvB* arv, Node* n);
+static int descarregaSubarvore(ArvB* arv, Node* n);
+static int totalPendentes(Node* n);
+static void coletaApagada(int chave, int registro, void* contexto);
 static void splitNodeFilho(ArvB* arv, Node* pai, Node* filho, int idxFilho);
 static int minChaves(int ordem);
 static void redistribuiDaEsquerda(ArvB* arv, Node* pai, int idxFilho, Node* filho, Node* irmaoEsq);
@@ -78,8 +226,17 @@ static void redistribuiDaDireita(ArvB* arv, Node* pai, int idxFilho, Node* filho
 static void concatenaComIrmaoEsquerdo(ArvB* arv, Node* pai, int idxFilho, Node* filho, Node* irmaoEsq);
 static void removeFolha(ArvB *arv, Node *n, int idxChave);
 static void rebalanceia(ArvB* arv, Node* pai, Node* filho, int idxFilho);
-static void removeChaveValorRec(ArvB* arv, Node* n, int chave);
+static int removeChaveValorRec(ArvB* arv, Node* n, int chave, int* registroRemovido);
 static int trocaChaveComPredecessor(ArvB* arv, Node* n, Node* filho, int idxChave);
+static int alturaArvB(ArvB* arv);
+static void liberaSubarvore(ArvB* arv, int posNode, int altura);
+static Subarvore removeIntervaloRec(ArvB* arv, int posNode, int altura, int chaveMin, int chaveMax, long long limInf,
+                                    long long limSup, int* separador, int* registroSeparador, int* numRemovidas);
+static Subarvore encaixaSubarvore(ArvB* arv, Node* n, int altura, int idx, Subarvore sub);
+static Subarvore juntaSubarvores(ArvB* arv, Subarvore esq, int chave, int registro, Subarvore dir);
+static void insereNaBorda(ArvB* arv, Node* n, int altura, int chave, int registro, Subarvore sub, int naDireita);
+static int equilibraFilhos(ArvB* arv, Node* pai, int idxEsq);
+static void redistribuiUniforme(ArvB* arv, Node* pai, int idxEsq, Node* esq, Node* dir);
 // ---
 
 // --- IMPLEMENTAÇÕES
@@ -88,14 +245,279 @@ ArvB* criaArvB(int ordem) {
     arv->ordem = ordem;
     arv->numNos = 0;
     arv->offsetAcumulado = 0;
-    arv->nodeSizeBytes = sizeof(int)*2 + sizeof(char) + sizeof(int)*ordem*3;
+    arv->slotsLivres = NULL;
+    arv->numSlotsLivres = arv->capacidadeSlotsLivres = 0;
+    arv->nodeSizeBytes = tamNodeBytes(ordem);
+    arv->nomeArqBin = malloc(strlen(NOME_ARQ_BIN) + 1);
+    strcpy(arv->nomeArqBin, NOME_ARQ_BIN);
     arv->arqBin = NULL;
+    arv->pagina = malloc(tamNodeBytes(ordem));
+    arv->acessoDireto = FALSE;
+    arv->logValores = NULL;
+    arv->emMemoria = FALSE;
+    arv->arena = NULL;
+    arv->capacidadeArena = 0;
+    arv->nodesLivres = NULL;
+    arv->filtro = NULL;
+    arv->consultasFiltro = arv->negativasFiltro = arv->falsosPositivosFiltro = 0;
+    arv->tamPagina = 0;
+    arv->capacidadeBuffer = 0;
+    arv->paginaRaiz = NULL;
+    arv->bufferConsolidado = TRUE;
+    arv->apagadas = (VetorChaves){.chaves = NULL, .num = 0, .capacidade = 0};
+    arv->apagadasDesconhecidas = FALSE;
+
+    return arv;
+}
+
+ArvB* criaArvBPagina(int tamPaginaBytes) {
+    int ordem = ordemPorTamPagina(tamPaginaBytes);
+    if(ordem < ORDEM_MINIMA) return NULL;
+
+    ArvB* arv = criaArvB(ordem);
+    arv->nodeSizeBytes = tamPaginaBytes; // cada nó ocupa exatamente uma página, alinhada no arq. bin.
+    arv->tamPagina = tamPaginaBytes;
+    return arv;
+}
+
+ArvB* criaArvBMemoria(int ordem) {
+    ArvB* arv = criaArvB(ordem);
+    arv->emMemoria = TRUE;
 
+    // os slots são arredondados para um múltiplo da linha de cache para que nenhum nó compartilhe linha com o vizinho
+    arv->nodeSizeBytes = (tamNodeBytes(ordem) + TAM_LINHA_CACHE - 1) / TAM_LINHA_CACHE * TAM_LINHA_CACHE;
     return arv;
 }
 
+int salvaArvB(ArvB* arv, const char* nomeArq) {
+    if(arv == NULL || nomeArq == NULL) return 0;
+
+    FILE* arq = fopen(nomeArq, "wb");
+    if(arq == NULL) return 0;
+
+    // cabeçalho seguido dos slots, todos no formato compacto do arq. bin., e das posições livres
+    int temFiltro = arv->filtro != NULL;
+    int cabecalho[TAM_CABECALHO_RETRATO] = {MAGICO_RETRATO, VERSAO_RETRATO, arv->ordem, arv->numNos,
+                                            arv->offsetAcumulado, arv->capacidadeBuffer, temFiltro, arv->numSlotsLivres};
+    int gravado = fwrite(cabecalho, sizeof(int), TAM_CABECALHO_RETRATO, arq) == TAM_CABECALHO_RETRATO;
+    for(int i = 0; gravado && i < arv->offsetAcumulado && !arvBVazia(arv); i++) {
+        gravado = fwrite(lePagina(arv, i), 1, tamNodeBytesArv(arv), arq) == (size_t)tamNodeBytesArv(arv);
+    }
+    if(gravado) gravado = fwrite(arv->slotsLivres, sizeof(int), arv->numSlotsLivres, arq) == (size_t)arv->numSlotsLivres;
+    if(fclose(arq) != 0) gravado = FALSE; // o que ficou no buffer do arquivo só é gravado no fechamento
+
+    // o filtro, se habilitado, é salvo ao lado do retrato; sem ele, um filtro de um retrato anterior é apagado
+    char* nomeFiltro = nomeArqDerivado(nomeArq, EXTENSAO_FILTRO);
+    if(temFiltro) gravado = gravado && salvaFiltro(arv->filtro, nomeFiltro);
+    else remove(nomeFiltro);
+    if(!gravado) { // um retrato incompleto nunca é deixado para trás
+        remove(nomeArq);
+        remove(nomeFiltro);
+    }
+    free(nomeFiltro);
+
+    return gravado;
+}
+
+ArvB* carregaArvB(const char* nomeArq) {
+    FILE* arq = nomeArq ? fopen(nomeArq, "rb") : NULL;
+    if(arq == NULL) return NULL;
+
+    fseek(arq, 0, SEEK_END);
+    long tamArq = ftell(arq);
+    fseek(arq, 0, SEEK_SET);
+
+    // o cabeçalho é validado antes de qualquer alocação (a ordem e a capacidade do buffer são limitadas para que o
+    // tamanho do nó não transborde), e o tamanho esperado dos slots e das posições livres é conferido em seguida
+    int cabecalho[TAM_CABECALHO_RETRATO];
+    if(fread(cabecalho, sizeof(int), TAM_CABECALHO_RETRATO, arq) != TAM_CABECALHO_RETRATO ||
+       cabecalho[0] != MAGICO_RETRATO || cabecalho[1] != VERSAO_RETRATO) {
+        fclose(arq);
+        return NULL;
+    }
+    int ordem = cabecalho[2], numNos = cabecalho[3], offsetAcumulado = cabecalho[4], capacidadeBuffer = cabecalho[5];
+    int temFiltro = cabecalho[6], numSlotsLivres = cabecalho[7];
+    if(ordem < ORDEM_MINIMA || ordem > INT_MAX / 64 || capacidadeBuffer < 0 || capacidadeBuffer > INT_MAX / 64 ||
+       numNos < 0 || numSlotsLivres < 0 || numNos + numSlotsLivres != offsetAcumulado || (temFiltro != 0 && temFiltro != 1)) {
+        fclose(arq);
+        return NULL;
+    }
+
+    ArvB* arv = criaArvBMemoria(ordem);
+    if(capacidadeBuffer > 0) {
+        habilitaBufferArvB(arv, capacidadeBuffer);
+        arv->bufferConsolidado = FALSE; // o retrato pode ter mensagens pendentes
+        arv->apagadasDesconhecidas = TRUE; // e chaves apagadas ainda não removidas
+    }
+    int numSlots = numNos > 0 ? offsetAcumulado : 0;
+    long long tamEsperado = sizeof(int)*(long long)(TAM_CABECALHO_RETRATO + numSlotsLivres) +
+                            (long long)numSlots*tamNodeBytesArv(arv);
+    if(arv->capacidadeBuffer != capacidadeBuffer || tamEsperado != tamArq) {
+        fclose(arq);
+        liberaArvB(arv);
+        return NULL;
+    }
+
+    arv->numNos = numNos;
+    arv->offsetAcumulado = offsetAcumulado;
+    garanteCapacidadeArena(arv, offsetAcumulado);
+    int lido = TRUE;
+    for(int i = 0; lido && i < numSlots; i++) {
+        lido = fread(arv->arena + (size_t)i*arv->nodeSizeBytes, 1, tamNodeBytesArv(arv), arq) == (size_t)tamNodeBytesArv(arv);
+    }
+    if(lido && numSlotsLivres > 0) {
+        arv->slotsLivres = malloc(sizeof(int)*numSlotsLivres);
+        arv->numSlotsLivres = arv->capacidadeSlotsLivres = numSlotsLivres;
+        lido = fread(arv->slotsLivres, sizeof(int), numSlotsLivres, arq) == (size_t)numSlotsLivres;
+        for(int i = 0; lido && i < numSlotsLivres; i++) {
+            lido = arv->slotsLivres[i] > POSICAO_RAIZ && arv->slotsLivres[i] < offsetAcumulado;
+        }
+    }
+    fclose(arq);
+
+    // o cabeçalho indica se o filtro foi salvo junto, para que um arquivo de filtro de outro retrato nunca seja usado
+    if(lido && temFiltro) {
+        char* nomeFiltro = nomeArqDerivado(nomeArq, EXTENSAO_FILTRO);
+        arv->filtro = carregaFiltro(nomeFiltro);
+        lido = arv->filtro != NULL;
+        free(nomeFiltro);
+    }
+
+    if(!lido) {
+        liberaArvB(arv);
+        return NULL;
+    }
+    return arv;
+}
+
+int ordemPorTamPagina(int tamPaginaBytes) {
+    if(tamPaginaBytes < tamNodeBytes(ORDEM_MINIMA)) return -1;
+
+    // tamNodeBytes é linear na ordem: o cabeçalho fixo é descontado e o restante é dividido pelo custo de cada
+    // unidade de ordem (uma chave, um registro, um filho e a contagem da sua subárvore)
+    int bytesPorOrdem = tamNodeBytes(ORDEM_MINIMA + 1) - tamNodeBytes(ORDEM_MINIMA);
+    return ORDEM_MINIMA + (tamPaginaBytes - tamNodeBytes(ORDEM_MINIMA)) / bytesPorOrdem;
+}
+
+int defineArqBinArvB(ArvB* arv, const char* nomeArqBin) {
+    if(arv == NULL || nomeArqBin == NULL || arv->arqBin != NULL) return 0; // o arq. bin. já está em uso
+
+    free(arv->nomeArqBin);
+    arv->nomeArqBin = malloc(strlen(nomeArqBin) + 1);
+    strcpy(arv->nomeArqBin, nomeArqBin);
+    return 1;
+}
+
+int defineAcessoDiretoArvB(ArvB* arv, int acessoDireto) {
+    if(arv == NULL || arv->emMemoria) return 0;
+
+    arv->acessoDireto = acessoDireto ? TRUE : FALSE;
+    if(arv->acessoDireto && arv->arqBin != NULL) { // as páginas já gravadas também deixam o cache
+        fflush(arv->arqBin);
+        fsync(fileno(arv->arqBin));
+        posix_fadvise(fileno(arv->arqBin), 0, 0, POSIX_FADV_DONTNEED);
+    }
+    return 1;
+}
+
+int getOrdemArvB(ArvB* arv) {
+    if(arv == NULL) return -1;
+    return arv->ordem;
+}
+
+int habilitaFiltroArvB(ArvB* arv, int numChavesEsperadas, double taxaFalsoPositivo) {
+    // o filtro precisa conhecer todas as chaves da árvore, portanto só pode ser criado com ela vazia (e sem buffers, cujas
+    // mensagens só revelam se a chave é nova quando chegam ao destino)
+    if(arv == NULL || arv->filtro != NULL || !arvBVazia(arv) || arv->capacidadeBuffer > 0) return 0;
+
+    arv->filtro = criaFiltro(numChavesEsperadas, taxaFalsoPositivo);
+    return arv->filtro != NULL;
+}
+
+int habilitaBufferArvB(ArvB* arv, int capacidadeBuffer) {
+    // o tamanho dos nós muda, então o modo só pode ser escolhido com a árvore vazia e antes da criação do arq. bin.
+    if(arv == NULL || capacidadeBuffer <= 0 || arv->capacidadeBuffer > 0 || arv->filtro != NULL || !arvBVazia(arv)
+       || arv->arqBin != NULL) return 0;
+
+    if(arv->tamPagina > 0) { // o buffer ocupa parte da página e a ordem é reduzida para que o restante comporte o nó
+        int ordem = ordemPorTamPagina(arv->tamPagina - tamBufferBytes(ORDEM_MINIMA, capacidadeBuffer));
+        while(ordem >= ORDEM_MINIMA && tamNodeBytes(ordem) + tamBufferBytes(ordem, capacidadeBuffer) > arv->tamPagina) {
+            ordem--; // as contagens de mensagens pendentes também crescem com a ordem
+        }
+        if(ordem < ORDEM_MINIMA) return 0;
+        arv->ordem = ordem;
+    }
+
+    arv->capacidadeBuffer = capacidadeBuffer;
+    if(arv->emMemoria) {
+        arv->nodeSizeBytes = (tamNodeBytesArv(arv) + TAM_LINHA_CACHE - 1) / TAM_LINHA_CACHE * TAM_LINHA_CACHE;
+    } else if(arv->tamPagina == 0) {
+        arv->nodeSizeBytes = tamNodeBytesArv(arv);
+    }
+    arv->pagina = realloc(arv->pagina, tamNodeBytesArv(arv));
+    if(!arv->emMemoria) arv->paginaRaiz = malloc(tamNodeBytesArv(arv));
+
+    // a arena e os blocos de nós livres foram dimensionados para o nó sem buffer
+    free(arv->arena);
+    arv->arena = NULL;
+    arv->capacidadeArena = 0;
+    liberaNodesLivres(arv);
+
+    return 1;
+}
+
+void descarregaBuffersArvB(ArvB* arv) {
+    if(arv == NULL || arv->capacidadeBuffer == 0 || arv->bufferConsolidado || arvBVazia(arv)) return;
+
+    // todas as mensagens descem até as folhas (ou até a chave separadora correspondente); se a raíz virar super node,
+    // ela é splitada e a descida recomeça pela nova raíz
+    int raizSplitada = TRUE;
+    while(raizSplitada) {
+        Node* raiz = leNodeArqBin(POSICAO_RAIZ, arv);
+        descarregaSubarvore(arv, raiz);
+        raizSplitada = raiz->ehSuperNode;
+        if(raizSplitada) splitRaiz(arv, raiz);
+        else escreveNodeArqBin(arv, raiz);
+        liberaNode(arv, raiz);
+    }
+
+    // com os buffers vazios, as chaves apagadas são removidas pelo procedimento usual (concatenação/redistribuição);
+    // só as chaves registradas são visitadas, a não ser após a carga de um retrato
+    if(arv->apagadasDesconhecidas) {
+        arv->apagadas.num = 0;
+        percorreIntervaloRec(arv, POSICAO_RAIZ, 0, INT_MAX, coletaApagada, &arv->apagadas);
+        arv->apagadasDesconhecidas = FALSE;
+    }
+    for(int i = 0; i < arv->apagadas.num; i++) {
+        int chave = arv->apagadas.chaves[i];
+        if(buscaChaveNode(arv, POSICAO_RAIZ, chave, NULL)) continue; // chave reinserida depois da remoção
+        Node* raiz = leNodeArqBin(POSICAO_RAIZ, arv);
+        removeChaveValorRec(arv, raiz, chave, NULL); // sem efeito se a chave já tiver sido removida
+        liberaNode(arv, raiz);
+    }
+    arv->apagadas.num = 0;
+
+    // a raíz só chega ao arq. bin. nas consolidações
+    if(arv->paginaRaiz) {
+        fseek(arv->arqBin, (long)POSICAO_RAIZ*arv->nodeSizeBytes, SEEK_SET);
+        fwrite(arv->paginaRaiz, 1, tamNodeBytesArv(arv), arv->arqBin);
+        fflush(arv->arqBin);
+        descartaCachePagina(arv, POSICAO_RAIZ, TRUE);
+    }
+
+    arv->bufferConsolidado = TRUE;
+}
+
+void estatisticasFiltroArvB(ArvB* arv, long* consultas, long* negativas, long* falsosPositivos) {
+    if(arv == NULL) return;
+    if(consultas) *consultas = arv->consultasFiltro;
+    if(negativas) *negativas = arv->negativasFiltro;
+    if(falsosPositivos) *falsosPositivos = arv->falsosPositivosFiltro;
+}
+
 void imprimeArvB(ArvB* arv, FILE* saida) {
     if(arv == NULL || arvBVazia(arv)) return;
+    descarregaBuffersArvB(arv); // a impressão mostra a árvore sem mensagens pendentes
     
     fprintf(saida, "-- ARVORE B\n");
     
@@ -121,7 +543,7 @@ void imprimeArvB(ArvB* arv, FILE* saida) {
                 }
             }
     
-            liberaNode(nAtual);
+            liberaNode(arv, nAtual);
         }
 
         fprintf(saida, "\n");
@@ -132,96 +554,360 @@ void imprimeArvB(ArvB* arv, FILE* saida) {
 
 void liberaArvB(ArvB* arv) {
     if(arv == NULL) return;
-    if(arv->arqBin) fclose(arv->arqBin);
-    if(arv) free(arv);
-    remove(NOME_ARQ_BIN);
+    if(arv->arqBin) {
+        fclose(arv->arqBin);
+        remove(arv->nomeArqBin);
+    }
+    liberaLogValores(arv->logValores, TRUE);
+    free(arv->nomeArqBin);
+    free(arv->pagina);
+    free(arv->paginaRaiz);
+    free(arv->arena);
+    liberaFiltro(arv->filtro);
+    liberaNodesLivres(arv);
+    free(arv->apagadas.chaves);
+    free(arv->slotsLivres);
+    free(arv);
 }
 
 void insereChaveValor(ArvB* arv, int chave, int registro) {
-    if(arv == NULL || chave < 0) return;
-    
-    if(arv->arqBin == NULL) { // arquivo binário ainda não existe
-        arv->arqBin = fopen(NOME_ARQ_BIN, "wb+");
-    }
-
-    Node* raiz = NULL;
-    if(arvBVazia(arv)) {
-        raiz = criaNode(arv->ordem, TRUE, 0);
-        arv->numNos++;
-        arv->offsetAcumulado++;
-    } else { // se a raíz já existir ela é recuperada do arq. bin.
-        raiz = leNodeArqBin(POSICAO_RAIZ, arv);
+    if(arv == NULL || chave < 0 || registroReservado(arv, registro)) return;
+    if(arv->capacidadeBuffer > 0) {
+        insereMensagem(arv, chave, registro);
+        return;
     }
 
-    insereChaveValorRec(arv, raiz, chave, registro);
-    if(raiz->ehSuperNode) { // se a raíz virou super node, ela é splitada e uma nova raíz é criada
-        Node* novaRaiz = criaNode(arv->ordem, FALSE, POSICAO_RAIZ);
-        novaRaiz->filhos[0] = raiz->posicaoArqBin;
-        raiz->posicaoArqBin = arv->offsetAcumulado; // antiga raíz vai para a o final do arq. bin.
-        arv->numNos++;
-        arv->offsetAcumulado++;
-        
-        splitNodeFilho(arv, novaRaiz, raiz, 0);
-        liberaNode(novaRaiz);
-    }
-    liberaNode(raiz);
+    Operacao op = {.tipo = ATRIBUICAO, .registro = registro};
+    executaOperacao(arv, chave, &op);
 }
 
 int buscaChave(ArvB* arv, int chave, int* registroBuscado) {
     if(arv == NULL || arvBVazia(arv) || chave < 0) return 0;
 
-    Node* raiz = leNodeArqBin(POSICAO_RAIZ, arv);
-    int chaveEncontrada = 0;
-    int idx = buscaBinaria(chave, raiz->chaves, 0, raiz->numChavesArmazenadas-1);
-    if(idx < raiz->numChavesArmazenadas && raiz->chaves[idx] == chave) {
-        if(registroBuscado != NULL) *registroBuscado = raiz->registros[idx];
-        chaveEncontrada = 1;
-    } else if(!raiz->ehFolha) {
-        chaveEncontrada = buscaChaveNode(arv, raiz->filhos[idx], chave, registroBuscado);
-    }
+    if(!consultaFiltroArvB(arv, chave)) return 0; // ausência garantida: nenhum nó precisa ser lido
 
-    liberaNode(raiz);
+    int chaveEncontrada = buscaChaveNode(arv, POSICAO_RAIZ, chave, registroBuscado);
+
+    if(arv->filtro && !chaveEncontrada) arv->falsosPositivosFiltro++;
     return chaveEncontrada;
 }
 
+int insereChaveBytes(ArvB* arv, int chave, const void* valor, int tamValor) {
+    if(arv == NULL || chave < 0 || tamValor < 0) return 0;
+
+    if(arv->logValores == NULL) {
+        char* nomeLog = nomeArqDerivado(arv->nomeArqBin, EXTENSAO_LOG);
+        arv->logValores = criaLogValores(nomeLog);
+        free(nomeLog);
+        if(arv->logValores == NULL) return 0;
+    }
+
+    // o valor vai para o final do log e o nó guarda apenas o deslocamento da entrada; a entrada anterior da chave,
+    // se houver, passa a ser lixo recuperado por compactaLogValores
+    int offset = anexaValorLog(arv->logValores, chave, valor, tamValor);
+    if(offset == -1) return 0; // log cheio: a chave mantém o valor anterior
+    insereChaveValor(arv, chave, offset);
+    return 1;
+}
+
+int buscaChaveBytes(ArvB* arv, int chave, void* valor, int tamMax) {
+    if(arv == NULL || arv->logValores == NULL) return -1;
+
+    int offset = 0;
+    if(!buscaChave(arv, chave, &offset)) return -1;
+    return leValorLog(arv->logValores, offset, NULL, valor, tamMax);
+}
+
+int compactaLogValores(ArvB* arv) {
+    if(arv == NULL || arv->logValores == NULL || getTamLog(arv->logValores) == 0) return 0;
+
+    LogValores* antigo = arv->logValores;
+    char* nomeLog = nomeArqDerivado(arv->nomeArqBin, EXTENSAO_LOG);
+    char* nomeTemporario = nomeArqDerivado(arv->nomeArqBin, EXTENSAO_LOG EXTENSAO_TEMPORARIO);
+    LogValores* novo = criaLogValores(nomeTemporario);
+    free(nomeTemporario);
+    if(novo == NULL) {
+        free(nomeLog);
+        return 0;
+    }
+
+    int tamBuffer = 0;
+    char* buffer = NULL;
+    for(int offset = 0; offset != -1; offset = proximaEntradaLog(antigo, offset)) {
+        int chave = 0, offsetAtual = 0;
+        int tamValor = leValorLog(antigo, offset, &chave, NULL, 0);
+
+        // uma entrada só está viva se a árvore ainda aponta para ela
+        if(!buscaChave(arv, chave, &offsetAtual) || offsetAtual != offset) continue;
+
+        if(tamValor > tamBuffer) {
+            tamBuffer = tamValor;
+            buffer = realloc(buffer, tamBuffer);
+        }
+        leValorLog(antigo, offset, NULL, buffer, tamValor);
+        insereChaveValor(arv, chave, anexaValorLog(novo, chave, buffer, tamValor)); // apenas o registro da folha é reescrito
+    }
+    free(buffer);
+
+    int bytesRecuperados = getTamLog(antigo) - getTamLog(novo);
+    liberaLogValores(antigo, TRUE);
+    renomeiaLogValores(novo, nomeLog);
+    arv->logValores = novo;
+    free(nomeLog);
+
+    return bytesRecuperados;
+}
+
 void removeChaveValor(ArvB* arv, int chave) {
     if (arv == NULL || arvBVazia(arv)) return;
+    if(arv->capacidadeBuffer > 0) { // a remoção também é uma mensagem, que apaga a chave quando chegar até ela
+        if(chave >= 0) insereMensagem(arv, chave, REGISTRO_APAGADO);
+        return;
+    }
+
+    removeERetorna(arv, chave, NULL);
+}
+
+int insereSeAusente(ArvB* arv, int chave, int registro, int* registroExistente) {
+    if(arv == NULL || chave < 0 || registroReservado(arv, registro)) return 0;
+
+    Operacao op = {.tipo = INSERCAO_SE_AUSENTE, .registro = registro};
+    executaOperacao(arv, chave, &op);
+
+    if(op.encontrada && registroExistente != NULL) *registroExistente = op.anterior;
+    return !op.encontrada;
+}
+
+int comparaETroca(ArvB* arv, int chave, int esperado, int novo, int* registroAtual) {
+    if(arv == NULL || chave < 0 || registroReservado(arv, novo)) return -1;
+
+    Operacao op = {.tipo = COMPARACAO_TROCA, .registro = novo, .esperado = esperado};
+    executaOperacao(arv, chave, &op);
+
+    if(!op.encontrada) return -1;
+    if(registroAtual != NULL) *registroAtual = op.anterior;
+    return op.anterior == esperado;
+}
+
+int acumulaRegistro(ArvB* arv, int chave, int incremento) {
+    if(arv == NULL || chave < 0) return 0;
+
+    Operacao op = {.tipo = ACUMULO, .registro = incremento};
+    executaOperacao(arv, chave, &op);
+    return op.resultado;
+}
+
+int removeERetorna(ArvB* arv, int chave, int* registroRemovido) {
+    if(arv == NULL || arvBVazia(arv) || chave < 0) return 0;
+
+    if(arv->capacidadeBuffer > 0) { // o registro atual é buscado e a remoção vira uma mensagem
+        if(!buscaChaveNode(arv, POSICAO_RAIZ, chave, registroRemovido)) return 0;
+        insereMensagem(arv, chave, REGISTRO_APAGADO);
+        return 1;
+    }
 
     Node* raiz = leNodeArqBin(POSICAO_RAIZ, arv);
-    removeChaveValorRec(arv, raiz, chave);
-    liberaNode(raiz);
+    int removida = removeChaveValorRec(arv, raiz, chave, registroRemovido);
+    if(removida) {
+        removeFiltro(arv->filtro, chave);
+    }
+    liberaNode(arv, raiz);
+    return removida;
 }
 
-static Node* criaNode(int ordem, char ehFolha, int posicaoArqBin) {
-    Node* novoNode = malloc(sizeof(Node));
+int removeIntervalo(ArvB* arv, int chaveMin, int chaveMax) {
+    if(arv == NULL || arvBVazia(arv) || chaveMax < 0 || chaveMin > chaveMax) return 0;
+    if(chaveMin < 0) chaveMin = 0;
+    descarregaBuffersArvB(arv); // o corte opera sobre a árvore sem mensagens pendentes
+
+    // os limites da raíz são as chaves possíveis: [0, INT_MAX]
+    int separador = -1, registroSeparador = 0, numRemovidas = 0;
+    Subarvore resultado = removeIntervaloRec(arv, POSICAO_RAIZ, alturaArvB(arv), chaveMin, chaveMax, -1,
+                                             (long long)INT_MAX + 1, &separador, &registroSeparador, &numRemovidas);
+
+    if(resultado.altura < 0) { // todos os nós foram descartados
+        arv->offsetAcumulado = 0;
+        arv->numSlotsLivres = 0;
+    } else if(resultado.posicao != POSICAO_RAIZ) { // a raíz do resultado passa a ocupar a posição da raíz
+        Node* raiz = leNodeArqBin(resultado.posicao, arv);
+        raiz->posicaoArqBin = POSICAO_RAIZ;
+        escreveNodeArqBin(arv, raiz);
+        liberaNode(arv, raiz);
+        arv->numNos++; // a posição da raíz, liberada no corte, volta a ser ocupada
+        liberaSlot(arv, resultado.posicao);
+    }
+
+    // a chave do intervalo mantida como separadora entre os dois caminhos sai pela remoção usual
+    if(separador >= 0) {
+        Node* raiz = leNodeArqBin(POSICAO_RAIZ, arv);
+        removeChaveValorRec(arv, raiz, separador, NULL);
+        removeFiltro(arv->filtro, separador);
+        liberaNode(arv, raiz);
+    }
+
+    return numRemovidas;
+}
+
+void percorreIntervalo(ArvB* arv, int chaveMin, int chaveMax, VisitaChave visita, void* contexto) {
+    if(arv == NULL || arvBVazia(arv) || visita == NULL || chaveMin > chaveMax) return;
+    descarregaBuffersArvB(arv);
+
+    percorreIntervaloRec(arv, POSICAO_RAIZ, chaveMin, chaveMax, visita, contexto);
+}
+
+int rankChave(ArvB* arv, int chave) {
+    if(arv == NULL || arvBVazia(arv)) return 0;
+    descarregaBuffersArvB(arv); // as contagens só refletem as mensagens que já chegaram ao destino
+
+    return contaMenores(arv, chave, NULL);
+}
+
+int selecionaK(ArvB* arv, int k, int* chave, int* registro) {
+    if(arv == NULL || arvBVazia(arv) || k < 0) return 0;
+    descarregaBuffersArvB(arv);
+
+    // a cada nó, 'k' é descontado das subárvores e chaves que ficam inteiramente à esquerda da k-ésima chave
+    Node* n = leNodeArqBin(POSICAO_RAIZ, arv);
+    int encontrada = 0;
+    while(n != NULL) {
+        Node* proximo = NULL;
+        if(n->ehFolha) {
+            if(k < n->numChavesArmazenadas) {
+                if(chave != NULL) *chave = n->chaves[k];
+                if(registro != NULL) *registro = n->registros[k];
+                encontrada = 1;
+            }
+        } else {
+            // cada subárvore é seguida da sua chave separadora: pula os pares que ficam antes da k-ésima chave
+            int i = 0;
+            while(i < n->numChavesArmazenadas && k > n->contagens[i]) {
+                k -= n->contagens[i] + 1;
+                i++;
+            }
+
+            if(k < n->contagens[i]) {
+                proximo = leNodeArqBin(n->filhos[i], arv);
+            } else if(i < n->numChavesArmazenadas) { // k == contagens[i]: é a própria separadora
+                if(chave != NULL) *chave = n->chaves[i];
+                if(registro != NULL) *registro = n->registros[i];
+                encontrada = 1;
+            }
+        }
+
+        liberaNode(arv, n);
+        n = proximo;
+    }
+
+    return encontrada;
+}
+
+int contaIntervalo(ArvB* arv, int chaveMin, int chaveMax) {
+    if(arv == NULL || arvBVazia(arv) || chaveMin > chaveMax) return 0;
+    descarregaBuffersArvB(arv);
+
+    // um caminho por extremo: chaves < chaveMax (mais ela própria, se presente) menos as chaves < chaveMin
+    int maxPresente = 0;
+    int ateMax = contaMenores(arv, chaveMax, &maxPresente);
+    return ateMax + maxPresente - contaMenores(arv, chaveMin, NULL);
+}
+
+// Obtém um nó da lista de nós livres da árvore. Um novo bloco (estrutura e vetores contíguos) só é alocado quando a lista
+// está vazia, o que deixa de acontecer assim que a lista comporta todos os nós usados simultaneamente por uma operação.
+static Node* criaNode(ArvB* arv, char ehFolha, int posicaoArqBin) {
+    int ordem = arv->ordem;
+    Node* novoNode = arv->nodesLivres;
+    if(novoNode != NULL) {
+        arv->nodesLivres = novoNode->proxLivre;
+    } else {
+        int capacidadeBuffer = arv->capacidadeBuffer;
+        novoNode = calloc(1, sizeof(Node) + sizeof(int)*(ordem + ordem + (ordem + 1)*3 + capacidadeBuffer*2));
+        novoNode->chaves = (int*)(novoNode + 1);
+        novoNode->registros = novoNode->chaves + ordem;
+        novoNode->filhos = novoNode->registros + ordem;
+        novoNode->contagens = novoNode->filhos + ordem + 1;
+        novoNode->pendentes = novoNode->contagens + ordem + 1;
+        novoNode->chavesBuffer = novoNode->pendentes + ordem + 1;
+        novoNode->registrosBuffer = novoNode->chavesBuffer + capacidadeBuffer;
+    }
 
     novoNode->ehFolha = ehFolha;
     novoNode->ehSuperNode = FALSE;
     novoNode->ehMiniNode = FALSE;
     novoNode->numChavesArmazenadas = 0;
+    novoNode->numMensagens = 0;
+    if(arv->capacidadeBuffer > 0) memset(novoNode->pendentes, 0, sizeof(int)*(ordem + 1));
     novoNode->posicaoArqBin = posicaoArqBin;
-
-    novoNode->chaves = calloc(ordem, sizeof(int));
-    novoNode->registros = calloc(ordem, sizeof(int));
-    novoNode->filhos = calloc(ordem + 1, sizeof(int));
+    novoNode->proxLivre = NULL;
 
     return novoNode;
 }
 
-static void liberaNode(Node* n) {
+// Devolve o nó à lista de nós livres da árvore (o bloco só é liberado em liberaArvB).
+static void liberaNode(ArvB* arv, Node* n) {
     if(n == NULL) return;
 
-    if(n->chaves) free(n->chaves);
-    if(n->registros) free(n->registros);
-    if(n->filhos) free(n->filhos);
-
-    free(n);
+    n->proxLivre = arv->nodesLivres;
+    arv->nodesLivres = n;
 }
 
 static int arvBVazia(ArvB* arv) {
     return arv->numNos == 0;
 }
 
+// Consulta o filtro de pertinência (se houver), contabilizando as consultas e as negativas. Retorna 0 se a chave
+// certamente não está na árvore e 1, caso contrário. Quem desce pela árvore após uma resposta positiva contabiliza o
+// falso positivo se não encontrar a chave.
+static int consultaFiltroArvB(ArvB* arv, int chave) {
+    if(arv->filtro == NULL) return TRUE;
+
+    arv->consultasFiltro++;
+    if(!consultaFiltro(arv->filtro, chave)) {
+        arv->negativasFiltro++;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Retorna o número de bytes ocupados por um nó serializado no arq. bin. (ver leNodeArqBin/escreveNodeArqBin)
+static int tamNodeBytes(int ordem) {
+    return sizeof(int) + sizeof(char) + sizeof(int) + sizeof(int)*(ordem-1)*2 + sizeof(int)*ordem*2;
+}
+
+// Retorna o número de bytes de um nó serializado da árvore, incluindo o buffer de mensagens no modo bufferizado
+static int tamNodeBytesArv(ArvB* arv) {
+    int bytesBuffer = arv->capacidadeBuffer > 0 ? tamBufferBytes(arv->ordem, arv->capacidadeBuffer) : 0;
+    return tamNodeBytes(arv->ordem) + bytesBuffer;
+}
+
+// Retorna o número de bytes do buffer serializado de um nó interno: o número de mensagens, as mensagens e as contagens
+// de mensagens pendentes nas subárvores dos filhos
+static int tamBufferBytes(int ordem, int capacidadeBuffer) {
+    return sizeof(int)*(1 + 2*capacidadeBuffer + ordem);
+}
+
+// Retorna o número de bytes do nó lidos/gravados no arq. bin. Todos os slots têm o tamanho de tamNodeBytesArv, pois a
+// posição do nó é o índice do slot e a raíz muda de folha para nó interno no mesmo slot, mas as folhas nunca guardam
+// mensagens (elas são aplicadas diretamente), então a parte do slot reservada ao buffer só é transferida nos nós internos.
+static int tamNodeBytesTransferidos(ArvB* arv, char ehFolha) {
+    return ehFolha ? tamNodeBytes(arv->ordem) : tamNodeBytesArv(arv);
+}
+
+static void liberaNodesLivres(ArvB* arv) {
+    while(arv->nodesLivres != NULL) {
+        Node* n = arv->nodesLivres;
+        arv->nodesLivres = n->proxLivre;
+        free(n);
+    }
+}
+
+// Retorna o nome do arquivo acrescido da extensão fornecida (a string retornada deve ser liberada pelo chamador)
+static char* nomeArqDerivado(const char* nomeArq, const char* extensao) {
+    char* nome = malloc(strlen(nomeArq) + strlen(extensao) + 1);
+    strcpy(nome, nomeArq);
+    strcat(nome, extensao);
+    return nome;
+}
+
 static int cheio(Node* n, int ordem) {
     return n->numChavesArmazenadas == (ordem-1);
 }
@@ -237,66 +923,288 @@ static int buscaBinaria(int c, int* chaves, int inicio, int fim) {
     else return idxMed;
 }
 
+// Aumenta a arena (dobrando sua capacidade) até que ela comporte 'numSlots' nós
+static void garanteCapacidadeArena(ArvB* arv, int numSlots) {
+    if(numSlots <= arv->capacidadeArena) return;
+
+    int novaCapacidade = arv->capacidadeArena > 0 ? arv->capacidadeArena : CAPACIDADE_INICIAL_ARENA;
+    while(novaCapacidade < numSlots) novaCapacidade *= 2;
+
+    // realloc não preserva o alinhamento, então a arena é realocada e copiada
+    unsigned char* novaArena = aligned_alloc(TAM_LINHA_CACHE, (size_t)novaCapacidade*arv->nodeSizeBytes);
+    if(arv->arena) memcpy(novaArena, arv->arena, (size_t)arv->capacidadeArena*arv->nodeSizeBytes);
+    free(arv->arena);
+    arv->arena = novaArena;
+    arv->capacidadeArena = novaCapacidade;
+}
+
+// Reserva a posição de um novo nó: a última posição liberada ou, se não houver, o final do arq. bin. (ou da arena)
+static int alocaSlot(ArvB* arv) {
+    arv->numNos++;
+    if(arv->numSlotsLivres > 0) return arv->slotsLivres[--arv->numSlotsLivres];
+    return arv->offsetAcumulado++;
+}
+
+// Libera a posição de um nó descartado para que ela seja reaproveitada. A posição da raíz não entra na lista: quando a
+// raíz é descartada, outro nó passa a ocupá-la.
+static void liberaSlot(ArvB* arv, int posicao) {
+    arv->numNos--;
+    if(posicao == POSICAO_RAIZ) return;
+
+    if(arv->numSlotsLivres == arv->capacidadeSlotsLivres) {
+        arv->capacidadeSlotsLivres = arv->capacidadeSlotsLivres > 0 ? arv->capacidadeSlotsLivres*2 : CAPACIDADE_INICIAL_ARENA;
+        arv->slotsLivres = realloc(arv->slotsLivres, arv->capacidadeSlotsLivres * sizeof(int));
+    }
+    arv->slotsLivres[arv->numSlotsLivres++] = posicao;
+}
+
+// Retorna a página serializada do nó de posição 'offset': o próprio slot da arena ou a página auxiliar da árvore
+// preenchida com a leitura do arq. bin.
+static unsigned char* lePagina(ArvB* arv, int offset) {
+    if(arv->emMemoria) return arv->arena + (size_t)offset*arv->nodeSizeBytes;
+    if(arv->paginaRaiz && offset == POSICAO_RAIZ) return arv->paginaRaiz;
+
+    fseek(arv->arqBin, (long)offset*arv->nodeSizeBytes, SEEK_SET);
+    fread(arv->pagina, 1, tamNodeBytes(arv->ordem), arv->arqBin);
+    char ehFolha = arv->pagina[sizeof(int)];
+    if(!ehFolha && arv->capacidadeBuffer > 0) { // o buffer é lido em seguida, apenas nos nós internos
+        fread(arv->pagina + tamNodeBytes(arv->ordem), 1, tamNodeBytesArv(arv) - tamNodeBytes(arv->ordem), arv->arqBin);
+    }
+    descartaCachePagina(arv, offset, FALSE);
+    return arv->pagina;
+}
+
+// Com o acesso direto habilitado, grava a página no dispositivo (se 'sincroniza') e a retira do cache do sistema, de
+// forma que o próximo acesso a ela também chegue ao dispositivo
+static void descartaCachePagina(ArvB* arv, int offset, int sincroniza) {
+    if(!arv->acessoDireto) return;
+
+    int fd = fileno(arv->arqBin);
+    if(sincroniza) fdatasync(fd);
+    posix_fadvise(fd, (off_t)offset*arv->nodeSizeBytes, arv->nodeSizeBytes, POSIX_FADV_DONTNEED);
+}
+
 static Node* leNodeArqBin(int offset, ArvB* arv) {
-    FILE* arqBin = arv->arqBin;
     int ordem = arv->ordem;
-    fseek(arqBin, offset*arv->nodeSizeBytes, SEEK_SET);
+    unsigned char* pagina = lePagina(arv, offset);
     
     int numChaves, posicaoBin;
     char ehFolha;
-    fread(&numChaves, sizeof(int), 1, arqBin);
-    fread(&ehFolha, sizeof(char), 1, arqBin);
-    fread(&posicaoBin, sizeof(int), 1, arqBin);
+    memcpy(&numChaves, pagina, sizeof(int)); pagina += sizeof(int);
+    memcpy(&ehFolha, pagina, sizeof(char)); pagina += sizeof(char);
+    memcpy(&posicaoBin, pagina, sizeof(int)); pagina += sizeof(int);
 
-    Node* n = criaNode(ordem, ehFolha, posicaoBin);
+    Node* n = criaNode(arv, ehFolha, posicaoBin);
     n->numChavesArmazenadas = numChaves;
-    fread(n->chaves, sizeof(int), ordem-1, arqBin);
-    fread(n->registros, sizeof(int), ordem-1, arqBin);
-    fread(n->filhos, sizeof(int), ordem, arqBin);
+    memcpy(n->chaves, pagina, sizeof(int)*(ordem-1)); pagina += sizeof(int)*(ordem-1);
+    memcpy(n->registros, pagina, sizeof(int)*(ordem-1)); pagina += sizeof(int)*(ordem-1);
+    memcpy(n->filhos, pagina, sizeof(int)*ordem); pagina += sizeof(int)*ordem;
+    memcpy(n->contagens, pagina, sizeof(int)*ordem); pagina += sizeof(int)*ordem;
+
+    if(arv->capacidadeBuffer > 0 && !ehFolha) { // apenas as mensagens ocupadas são copiadas
+        memcpy(&n->numMensagens, pagina, sizeof(int)); pagina += sizeof(int);
+        memcpy(n->chavesBuffer, pagina, sizeof(int)*n->numMensagens); pagina += sizeof(int)*arv->capacidadeBuffer;
+        memcpy(n->registrosBuffer, pagina, sizeof(int)*n->numMensagens); pagina += sizeof(int)*arv->capacidadeBuffer;
+        memcpy(n->pendentes, pagina, sizeof(int)*ordem);
+    }
 
     return n;
 }
 
 static void escreveNodeArqBin(ArvB* arv, Node* n) {
-    FILE* arqBin = arv->arqBin;
     int ordem = arv->ordem;
-    fseek(arqBin, n->posicaoArqBin*arv->nodeSizeBytes, SEEK_SET);
+    unsigned char* pagina = arv->pagina;
+    if(arv->emMemoria) {
+        garanteCapacidadeArena(arv, n->posicaoArqBin + 1);
+        pagina = arv->arena + (size_t)n->posicaoArqBin*arv->nodeSizeBytes;
+    } else if(arv->paginaRaiz && n->posicaoArqBin == POSICAO_RAIZ) {
+        pagina = arv->paginaRaiz;
+    }
 
-    fwrite(&n->numChavesArmazenadas, sizeof(int), 1, arqBin);
-    fwrite(&n->ehFolha, sizeof(char), 1, arqBin);
-    fwrite(&n->posicaoArqBin, sizeof(int), 1, arqBin);
-    fwrite(n->chaves, sizeof(int), (ordem-1), arqBin);
-    fwrite(n->registros, sizeof(int), (ordem-1), arqBin);
-    fwrite(n->filhos, sizeof(int), ordem, arqBin);
+    unsigned char* p = pagina;
+    memcpy(p, &n->numChavesArmazenadas, sizeof(int)); p += sizeof(int);
+    memcpy(p, &n->ehFolha, sizeof(char)); p += sizeof(char);
+    memcpy(p, &n->posicaoArqBin, sizeof(int)); p += sizeof(int);
+    memcpy(p, n->chaves, sizeof(int)*(ordem-1)); p += sizeof(int)*(ordem-1);
+    memcpy(p, n->registros, sizeof(int)*(ordem-1)); p += sizeof(int)*(ordem-1);
+    memcpy(p, n->filhos, sizeof(int)*ordem); p += sizeof(int)*ordem;
+    memcpy(p, n->contagens, sizeof(int)*ordem); p += sizeof(int)*ordem;
+
+    if(arv->capacidadeBuffer > 0 && !n->ehFolha) {
+        memcpy(p, &n->numMensagens, sizeof(int)); p += sizeof(int);
+        memcpy(p, n->chavesBuffer, sizeof(int)*n->numMensagens); p += sizeof(int)*arv->capacidadeBuffer;
+        memcpy(p, n->registrosBuffer, sizeof(int)*n->numMensagens); p += sizeof(int)*arv->capacidadeBuffer;
+        memcpy(p, n->pendentes, sizeof(int)*ordem);
+    }
 
-    fflush(arqBin);
+    if(!arv->emMemoria && pagina != arv->paginaRaiz) {
+        fseek(arv->arqBin, (long)n->posicaoArqBin*arv->nodeSizeBytes, SEEK_SET);
+        fwrite(pagina, 1, tamNodeBytesTransferidos(arv, n->ehFolha), arv->arqBin);
+        fflush(arv->arqBin);
+        descartaCachePagina(arv, n->posicaoArqBin, TRUE);
+    }
 }
 
 static int buscaChaveNode(ArvB* arv, int posNode, int chave, int* registroBuscado) {
     Node* n = leNodeArqBin(posNode, arv);
     int idx = buscaBinaria(chave, n->chaves, 0, n->numChavesArmazenadas-1);
+    int idxMensagem = buscaBinaria(chave, n->chavesBuffer, 0, n->numMensagens-1);
     
     int chaveEncontrada = 0;
-    if(idx < n->numChavesArmazenadas && n->chaves[idx] == chave) {
-        if(registroBuscado != NULL) *registroBuscado = n->registros[idx];
-        chaveEncontrada = 1;
+    if(idxMensagem < n->numMensagens && n->chavesBuffer[idxMensagem] == chave) { // a mensagem pendente é a mais recente
+        chaveEncontrada = registroVivo(arv, n->registrosBuffer[idxMensagem], registroBuscado);
+    } else if(idx < n->numChavesArmazenadas && n->chaves[idx] == chave) {
+        chaveEncontrada = registroVivo(arv, n->registros[idx], registroBuscado);
     } else if(!n->ehFolha) {
         chaveEncontrada = buscaChaveNode(arv, n->filhos[idx], chave, registroBuscado);
     }
 
-    liberaNode(n);
+    liberaNode(arv, n);
     return chaveEncontrada;
 }
 
-// Implementa a inserção recursiva pela árvore a partir do nó de entrada.
-static void insereChaveValorRec(ArvB* arv, Node* n, int chave, int registro) {
+// Percorre em ordem as chaves da subárvore que estão em [chaveMin, chaveMax], descendo apenas nos filhos que podem
+// conter chaves do intervalo.
+static void percorreIntervaloRec(ArvB* arv, int posNode, int chaveMin, int chaveMax, VisitaChave visita, void* contexto) {
+    Node* n = leNodeArqBin(posNode, arv);
+
+    // o filho 'i' contém as chaves entre chaves[i-1] e chaves[i], então a visita começa pela primeira chave >= chaveMin
+    for(int i = buscaBinaria(chaveMin, n->chaves, 0, n->numChavesArmazenadas-1); i <= n->numChavesArmazenadas; i++) {
+        if(!n->ehFolha) percorreIntervaloRec(arv, n->filhos[i], chaveMin, chaveMax, visita, contexto);
+        if(i == n->numChavesArmazenadas || n->chaves[i] > chaveMax) break;
+        visita(n->chaves[i], n->registros[i], contexto);
+    }
+
+    liberaNode(arv, n);
+}
+
+// Retorna o número de chaves da subárvore enraizada no nó
+static int totalChavesNode(Node* n) {
+    int total = n->numChavesArmazenadas;
+    for(int i = 0; !n->ehFolha && i <= n->numChavesArmazenadas; i++) {
+        total += n->contagens[i];
+    }
+    return total;
+}
+
+// Retorna o número de chaves da árvore menores que 'chave', percorrendo um único caminho a partir da raíz. Se
+// 'encontrada' não for NULL, indica se a própria chave está na árvore.
+static int contaMenores(ArvB* arv, int chave, int* encontrada) {
+    int menores = 0;
+    if(encontrada != NULL) *encontrada = FALSE;
+
+    Node* n = leNodeArqBin(POSICAO_RAIZ, arv);
+    while(n != NULL) {
+        // tudo à esquerda de 'idx' (chaves do nó e subárvores) é menor que a chave
+        int idx = buscaBinaria(chave, n->chaves, 0, n->numChavesArmazenadas-1);
+        menores += idx;
+        for(int i = 0; !n->ehFolha && i < idx; i++) {
+            menores += n->contagens[i];
+        }
+
+        Node* proximo = NULL;
+        if(idx < n->numChavesArmazenadas && n->chaves[idx] == chave) {
+            if(!n->ehFolha) menores += n->contagens[idx];
+            if(encontrada != NULL) *encontrada = TRUE;
+        } else if(!n->ehFolha) {
+            proximo = leNodeArqBin(n->filhos[idx], arv);
+        }
+
+        liberaNode(arv, n);
+        n = proximo;
+    }
+
+    return menores;
+}
+
+// Aplica a operação ao registro de uma chave presente. Retorna 1 se o registro mudou (e o nó precisa ser gravado).
+static int aplicaOperacao(Operacao* op, int* registro) {
+    op->encontrada = TRUE;
+    op->anterior = *registro;
+
+    int novo = *registro;
+    switch(op->tipo) {
+    case ATRIBUICAO:
+        novo = op->registro;
+        break;
+    case COMPARACAO_TROCA:
+        if(*registro == op->esperado) novo = op->registro;
+        break;
+    case ACUMULO: // a soma satura em INT_MAX e no menor registro permitido
+        if(__builtin_add_overflow(*registro, op->registro, &novo)) novo = op->registro > 0 ? INT_MAX : op->registroMinimo;
+        else if(novo < op->registroMinimo) novo = op->registroMinimo;
+        break;
+    default: // INSERCAO_SE_AUSENTE mantém o registro existente
+        break;
+    }
+
+    op->resultado = novo;
+    if(novo == *registro) return FALSE;
+    *registro = novo;
+    return TRUE;
+}
+
+// Retorna 1 se a operação insere a chave quando ela está ausente, com o registro em op->resultado (o da operação ou,
+// em um acúmulo de REGISTRO_APAGADO no modo bufferizado, o menor registro permitido)
+static int operacaoInsere(Operacao* op) {
+    op->resultado = op->registro < op->registroMinimo ? op->registroMinimo : op->registro;
+    return op->tipo != COMPARACAO_TROCA;
+}
+
+// Executa a operação sobre o registro da chave em uma única descida a partir da raíz, gravando apenas os nós que ela de
+// fato modifica. No modo bufferizado, o registro atual é buscado (considerando as mensagens pendentes) e o novo registro,
+// se mudar, é registrado como uma mensagem comum.
+static void executaOperacao(ArvB* arv, int chave, Operacao* op) {
+    op->encontrada = FALSE;
+    op->registroMinimo = arv->capacidadeBuffer > 0 ? REGISTRO_APAGADO + 1 : INT_MIN;
+
+    if(arv->capacidadeBuffer > 0) {
+        int registro = 0;
+        if(!arvBVazia(arv) && buscaChaveNode(arv, POSICAO_RAIZ, chave, &registro)) {
+            if(aplicaOperacao(op, &registro)) insereMensagem(arv, chave, registro);
+        } else if(operacaoInsere(op)) {
+            insereMensagem(arv, chave, op->resultado);
+        }
+        return;
+    }
+
+    // uma comparação com chave certamente ausente termina sem ler nenhum nó
+    if(op->tipo == COMPARACAO_TROCA && (arvBVazia(arv) || !consultaFiltroArvB(arv, chave))) return;
+
+    if(arv->arqBin == NULL && !arv->emMemoria) { // arquivo binário ainda não existe
+        arv->arqBin = fopen(arv->nomeArqBin, "wb+");
+    }
+
+    Node* raiz = NULL;
+    if(arvBVazia(arv)) {
+        raiz = criaNode(arv, TRUE, 0);
+        arv->numNos++;
+        arv->offsetAcumulado++;
+    } else { // se a raíz já existir ela é recuperada do arq. bin.
+        raiz = leNodeArqBin(POSICAO_RAIZ, arv);
+    }
+
+    if(insereChaveValorRec(arv, raiz, chave, op)) {
+        insereFiltro(arv->filtro, chave); // apenas chaves novas; atualizações não alteram o conjunto
+    }
+    if(op->tipo == COMPARACAO_TROCA && arv->filtro && !op->encontrada) arv->falsosPositivosFiltro++;
+    if(raiz->ehSuperNode) { // se a raíz virou super node, ela é splitada e uma nova raíz é criada
+        splitRaiz(arv, raiz);
+    }
+    liberaNode(arv, raiz);
+}
+
+// Implementa a inserção recursiva pela árvore a partir do nó de entrada, aplicando a operação ao registro se a chave já
+// estiver presente. Retorna 1 se a chave foi inserida e 0, caso contrário.
+static int insereChaveValorRec(ArvB* arv, Node* n, int chave, Operacao* op) {
     int idx = n->numChavesArmazenadas - 1;
+    int chaveNova = FALSE;
 
     if(n->ehFolha) {
         int i = buscaBinaria(chave, n->chaves, 0, n->numChavesArmazenadas-1);
-        if(i < n->numChavesArmazenadas && n->chaves[i] == chave) { // atualiza o registro caso a chave já esteja presente
-            n->registros[i] = registro;
-        } else {
+        if(i < n->numChavesArmazenadas && n->chaves[i] == chave) { // aplica a operação caso a chave já esteja presente
+            if(aplicaOperacao(op, &n->registros[i])) escreveNodeArqBin(arv, n);
+        } else if(operacaoInsere(op)) {
             if(cheio(n, arv->ordem)) {
                 n->ehSuperNode = TRUE;
             }
@@ -309,39 +1217,277 @@ static void insereChaveValorRec(ArvB* arv, Node* n, int chave, int registro) {
     
             int idxNovaChave = idx + 1;
             n->chaves[idxNovaChave] = chave;
-            n->registros[idxNovaChave] = registro;
-        }
+            n->registros[idxNovaChave] = op->resultado;
+            chaveNova = TRUE;
 
-        // se o nó não é super node, ele não será splitado pelo pai, logo pode ser atualizado no arq. bin..
-        // se ele fosse super node, não seria necessário passá-lo para o arq. uma vez que o split já fará isso
-        if(!n->ehSuperNode) 
-            escreveNodeArqBin(arv, n);
+            // se o nó não é super node, ele não será splitado pelo pai, logo pode ser atualizado no arq. bin..
+            // se ele fosse super node, não seria necessário passá-lo para o arq. uma vez que o split já fará isso
+            if(!n->ehSuperNode) 
+                escreveNodeArqBin(arv, n);
+        }
     } else {
         idx = buscaBinaria(chave, n->chaves, 0, n->numChavesArmazenadas-1);
 
-        if(idx < n->numChavesArmazenadas && n->chaves[idx] == chave) { // atualiza o registro caso a chave já esteja presente
-            n->registros[idx] = registro;
-            escreveNodeArqBin(arv, n);
+        if(idx < n->numChavesArmazenadas && n->chaves[idx] == chave) { // aplica a operação caso a chave já esteja presente
+            if(aplicaOperacao(op, &n->registros[idx])) escreveNodeArqBin(arv, n);
         } else {
             Node* nodeFilho = leNodeArqBin(n->filhos[idx], arv);
-            insereChaveValorRec(arv, nodeFilho, chave, registro);
+            chaveNova = insereChaveValorRec(arv, nodeFilho, chave, op);
     
             if(nodeFilho->ehSuperNode) {
-                splitNodeFilho(arv, n, nodeFilho, idx);
+                splitNodeFilho(arv, n, nodeFilho, idx); // recalcula as contagens dos dois filhos e grava o nó
+            } else if(chaveNova) {
+                n->contagens[idx]++; // a subárvore ganhou uma chave
+                escreveNodeArqBin(arv, n);
             }
-            liberaNode(nodeFilho);  
+            liberaNode(arv, nodeFilho);  
+        }
+
+    }
+
+    return chaveNova;
+}
+
+// Splita a raíz (super node): ela vai para o final do arq. bin. e uma nova raíz com a sua mediana é criada
+static void splitRaiz(ArvB* arv, Node* raiz) {
+    Node* novaRaiz = criaNode(arv, FALSE, POSICAO_RAIZ);
+    novaRaiz->filhos[0] = raiz->posicaoArqBin;
+    raiz->posicaoArqBin = alocaSlot(arv); // antiga raíz vai para uma posição livre ou para o final do arq. bin.
+    
+    splitNodeFilho(arv, novaRaiz, raiz, 0);
+    liberaNode(arv, novaRaiz);
+}
+
+// Retorna 1 e copia o registro se ele não marcar uma chave apagada (apenas no modo bufferizado) e 0, caso contrário
+static int registroVivo(ArvB* arv, int registro, int* registroBuscado) {
+    if(arv->capacidadeBuffer > 0 && registro == REGISTRO_APAGADO) return 0;
+
+    if(registroBuscado != NULL) *registroBuscado = registro;
+    return 1;
+}
+
+// Retorna 1 se o registro for o valor reservado REGISTRO_APAGADO (apenas no modo bufferizado) e 0, caso contrário
+static int registroReservado(ArvB* arv, int registro) {
+    return arv->capacidadeBuffer > 0 && registro == REGISTRO_APAGADO;
+}
+
+// Modo bufferizado: registra a inserção/atualização (ou remoção, com REGISTRO_APAGADO) no buffer da raíz. As mensagens só
+// descem um nível quando o buffer enche, em lotes destinados a um único filho.
+static void insereMensagem(ArvB* arv, int chave, int registro) {
+    if(arv->arqBin == NULL && !arv->emMemoria) { // arquivo binário ainda não existe
+        arv->arqBin = fopen(arv->nomeArqBin, "wb+");
+    }
+    arv->bufferConsolidado = FALSE;
+
+    // se a raíz enche o buffer e vira super node antes de aceitar a mensagem, ela é splitada e a nova raíz a recebe
+    int aplicada = FALSE;
+    while(!aplicada) {
+        Node* raiz = NULL;
+        if(arvBVazia(arv)) {
+            raiz = criaNode(arv, TRUE, 0);
+            arv->numNos++;
+            arv->offsetAcumulado++;
+        } else {
+            raiz = leNodeArqBin(POSICAO_RAIZ, arv);
+        }
+
+        int novas = 0;
+        aplicada = aplicaLoteNode(arv, raiz, &chave, &registro, 1, &novas);
+        if(raiz->ehSuperNode) splitRaiz(arv, raiz);
+        else escreveNodeArqBin(arv, raiz);
+        liberaNode(arv, raiz);
+    }
+}
+
+// Registra a mensagem no nó interno: substitui a mensagem pendente da mesma chave, atualiza a própria chave se ela for
+// separadora do nó ou ocupa uma nova posição do buffer. Retorna 0 se uma nova posição for necessária e o buffer estiver
+// cheio.
+static int registraMensagem(ArvB* arv, Node* n, int chave, int registro) {
+    int idxMensagem = buscaBinaria(chave, n->chavesBuffer, 0, n->numMensagens-1);
+    if(idxMensagem < n->numMensagens && n->chavesBuffer[idxMensagem] == chave) {
+        n->registrosBuffer[idxMensagem] = registro;
+        return TRUE;
+    }
+
+    int idx = buscaBinaria(chave, n->chaves, 0, n->numChavesArmazenadas-1);
+    if(idx < n->numChavesArmazenadas && n->chaves[idx] == chave) {
+        n->registros[idx] = registro;
+        coletaApagada(chave, registro, &arv->apagadas);
+        return TRUE;
+    }
+
+    if(n->numMensagens == arv->capacidadeBuffer) return FALSE;
+
+    for(int i = n->numMensagens - 1; i >= idxMensagem; i--) {
+        n->chavesBuffer[i+1] = n->chavesBuffer[i];
+        n->registrosBuffer[i+1] = n->registrosBuffer[i];
+    }
+    n->chavesBuffer[idxMensagem] = chave;
+    n->registrosBuffer[idxMensagem] = registro;
+    n->numMensagens++;
+    return TRUE;
+}
+
+// Aplica a mensagem à folha, sem gravá-la. Uma remoção apenas marca o registro como apagado, o que preserva a estrutura
+// até a consolidação. Retorna 1 se uma chave nova foi inserida.
+static int aplicaMensagemFolha(ArvB* arv, Node* folha, int chave, int registro) {
+    int idx = buscaBinaria(chave, folha->chaves, 0, folha->numChavesArmazenadas-1);
+    if(idx < folha->numChavesArmazenadas && folha->chaves[idx] == chave) {
+        folha->registros[idx] = registro;
+        coletaApagada(chave, registro, &arv->apagadas);
+        return FALSE;
+    }
+    if(registro == REGISTRO_APAGADO) return FALSE; // remoção de chave ausente
+
+    if(cheio(folha, arv->ordem)) folha->ehSuperNode = TRUE;
+    for(int i = folha->numChavesArmazenadas - 1; i >= idx; i--) {
+        folha->chaves[i+1] = folha->chaves[i];
+        folha->registros[i+1] = folha->registros[i];
+    }
+    folha->chaves[idx] = chave;
+    folha->registros[idx] = registro;
+    folha->numChavesArmazenadas++;
+    return TRUE;
+}
+
+// Aplica ao nó (sem gravá-lo) as mensagens ordenadas do lote, até o fim do lote ou até o nó virar super node e não poder
+// recebê-las. Retorna o número de mensagens aplicadas e soma em 'novas' as chaves novas inseridas na subárvore.
+static int aplicaLoteNode(ArvB* arv, Node* n, int* chaves, int* registros, int num, int* novas) {
+    int i = 0;
+    if(n->ehFolha) {
+        for(; i < num && !n->ehSuperNode; i++) {
+            *novas += aplicaMensagemFolha(arv, n, chaves[i], registros[i]);
+        }
+        return i;
+    }
+
+    for(; i < num; i++) {
+        while(!registraMensagem(arv, n, chaves[i], registros[i])) {
+            if(n->ehSuperNode) return i; // o pai precisa splitar o nó antes que ele descarregue mais mensagens
+            *novas += descarregaBuffer(arv, n);
+        }
+    }
+    return i;
+}
+
+// Aplica aos filhos de 'n' as mensagens ordenadas do lote (retiradas do buffer de 'n'), gravando-os e splitando os que
+// virarem super nodes. Para se 'n' virar super node. Retorna o número de mensagens aplicadas.
+static int aplicaLoteFilhos(ArvB* arv, Node* n, int* chaves, int* registros, int num, int* novas) {
+    int i = 0;
+    while(i < num && !n->ehSuperNode) {
+        int idx = buscaBinaria(chaves[i], n->chaves, 0, n->numChavesArmazenadas-1);
+        if(idx < n->numChavesArmazenadas && n->chaves[idx] == chaves[i]) { // chave promovida a 'n' por um split
+            n->registros[idx] = registros[i];
+            coletaApagada(chaves[i], registros[i], &arv->apagadas);
+            i++;
+            continue;
         }
 
+        // mensagens destinadas ao mesmo filho são contíguas
+        int fim = i;
+        while(fim < num && (idx == n->numChavesArmazenadas || chaves[fim] < n->chaves[idx])) fim++;
+
+        Node* filho = leNodeArqBin(n->filhos[idx], arv);
+        int novasFilho = 0;
+        i += aplicaLoteNode(arv, filho, chaves + i, registros + i, fim - i, &novasFilho);
+        n->contagens[idx] += novasFilho;
+        n->pendentes[idx] = totalPendentes(filho);
+        *novas += novasFilho;
+
+        if(filho->ehSuperNode) splitNodeFilho(arv, n, filho, idx); // as mensagens restantes são redirecionadas
+        else escreveNodeArqBin(arv, filho);
+        liberaNode(arv, filho);
     }
+    return i;
+}
+
+// Move para o filho que recebe mais mensagens o lote de mensagens do buffer de 'n' (nó interno, não super node). 'n' não
+// é gravado. Retorna o número de chaves novas inseridas na subárvore.
+static int descarregaBuffer(ArvB* arv, Node* n) {
+    // as mensagens estão ordenadas, então as de cada filho formam um intervalo do buffer
+    int inicioLote = 0, fimLote = 0;
+    for(int inicio = 0, idx = 0; inicio < n->numMensagens; idx++) {
+        int fim = inicio;
+        while(fim < n->numMensagens && (idx == n->numChavesArmazenadas || n->chavesBuffer[fim] < n->chaves[idx])) fim++;
+        if(fim - inicio > fimLote - inicioLote) {
+            inicioLote = inicio;
+            fimLote = fim;
+        }
+        inicio = fim;
+    }
+
+    int novas = 0;
+    int aplicadas = aplicaLoteFilhos(arv, n, n->chavesBuffer + inicioLote, n->registrosBuffer + inicioLote,
+                                     fimLote - inicioLote, &novas);
+
+    // retira do buffer as mensagens que desceram
+    for(int i = inicioLote; i + aplicadas < n->numMensagens; i++) {
+        n->chavesBuffer[i] = n->chavesBuffer[i + aplicadas];
+        n->registrosBuffer[i] = n->registrosBuffer[i + aplicadas];
+    }
+    n->numMensagens -= aplicadas;
+
+    return novas;
+}
+
+// Esvazia os buffers da subárvore de 'n' (que não é gravado), parando antes se 'n' virar super node e precisar ser
+// splitado pelo pai. Os filhos sem mensagens pendentes não são lidos. Retorna o número de chaves novas inseridas na
+// subárvore.
+static int descarregaSubarvore(ArvB* arv, Node* n) {
+    int novas = 0;
+    if(n->ehFolha) return novas;
+
+    while(n->numMensagens > 0 && !n->ehSuperNode) novas += descarregaBuffer(arv, n);
+
+    for(int i = 0; i <= n->numChavesArmazenadas && !n->ehSuperNode; ) {
+        if(n->pendentes[i] == 0) {
+            i++;
+            continue;
+        }
+        Node* filho = leNodeArqBin(n->filhos[i], arv);
+        int novasFilho = descarregaSubarvore(arv, filho);
+        n->contagens[i] += novasFilho;
+        n->pendentes[i] = totalPendentes(filho);
+        novas += novasFilho;
+
+        if(filho->ehSuperNode) {
+            splitNodeFilho(arv, n, filho, i); // as duas metades podem ter mensagens: o filho 'i' é revisitado
+        } else {
+            if(!filho->ehFolha) escreveNodeArqBin(arv, filho);
+            i++;
+        }
+        liberaNode(arv, filho);
+    }
+
+    return novas;
+}
+
+// Retorna o número de mensagens pendentes no buffer do nó e nas subárvores dos seus filhos
+static int totalPendentes(Node* n) {
+    if(n->ehFolha) return 0;
+
+    int total = n->numMensagens;
+    for(int i = 0; i <= n->numChavesArmazenadas; i++) total += n->pendentes[i];
+    return total;
+}
+
+// Acrescenta a chave ao VetorChaves do contexto se o seu registro marcar uma chave apagada
+static void coletaApagada(int chave, int registro, void* contexto) {
+    if(registro != REGISTRO_APAGADO) return;
+
+    VetorChaves* v = contexto;
+    if(v->num == v->capacidade) {
+        v->capacidade = v->capacidade > 0 ? v->capacidade*2 : CAPACIDADE_INICIAL_ARENA;
+        v->chaves = realloc(v->chaves, v->capacidade * sizeof(int));
+    }
+    v->chaves[v->num++] = chave;
 }
 
 // Os nós 'pai' e 'filho' não são retirados da memória principal após o split, apenas o novo nó criado é liberado.
 static void splitNodeFilho(ArvB* arv, Node* pai, Node* filho, int idxFilho) {
-    int posSegundoFilho = arv->offsetAcumulado; // a inserção será no final do arq. bin.
-    arv->numNos++;
-    arv->offsetAcumulado++;
+    int posSegundoFilho = alocaSlot(arv); // em uma posição livre ou no final do arq. bin.
 
-    Node* segundoFilho = criaNode(arv->ordem, filho->ehFolha, posSegundoFilho);
+    Node* segundoFilho = criaNode(arv, filho->ehFolha, posSegundoFilho);
 
     int idxMediana = filho->numChavesArmazenadas / 2; // índice da mediana das chaves de 'filho'
     
@@ -361,7 +1507,27 @@ static void splitNodeFilho(ArvB* arv, Node* pai, Node* filho, int idxFilho) {
     if(!filho->ehFolha) {
         for(int i = 0; i <= segundoFilho->numChavesArmazenadas; i++) {
             segundoFilho->filhos[i] = filho->filhos[offsetFilhoOriginal + i];
+            segundoFilho->contagens[i] = filho->contagens[offsetFilhoOriginal + i];
+            if(arv->capacidadeBuffer > 0) segundoFilho->pendentes[i] = filho->pendentes[offsetFilhoOriginal + i];
+        }
+    }
+
+    // no modo bufferizado, as mensagens pendentes acompanham a metade responsável pela sua chave; a mensagem da própria
+    // mediana é mais recente que ela e é aplicada antes da promoção
+    if(filho->numMensagens > 0) {
+        int mediana = filho->chaves[idxMediana];
+        int idxMensagem = buscaBinaria(mediana, filho->chavesBuffer, 0, filho->numMensagens-1);
+        int inicioSegundo = idxMensagem;
+        if(idxMensagem < filho->numMensagens && filho->chavesBuffer[idxMensagem] == mediana) {
+            filho->registros[idxMediana] = filho->registrosBuffer[idxMensagem];
+            coletaApagada(mediana, filho->registros[idxMediana], &arv->apagadas);
+            inicioSegundo++;
         }
+
+        segundoFilho->numMensagens = filho->numMensagens - inicioSegundo;
+        memcpy(segundoFilho->chavesBuffer, filho->chavesBuffer + inicioSegundo, sizeof(int)*segundoFilho->numMensagens);
+        memcpy(segundoFilho->registrosBuffer, filho->registrosBuffer + inicioSegundo, sizeof(int)*segundoFilho->numMensagens);
+        filho->numMensagens = idxMensagem;
     }
 
     // abre espaço para inserir a mediana do nó splitado no pai
@@ -374,6 +1540,8 @@ static void splitNodeFilho(ArvB* arv, Node* pai, Node* filho, int idxFilho) {
     // abre espaço para inserir as novas referências
     for(int i = numChavesPai; i >= idxFilho+1; i--) {
         pai->filhos[i+1] = pai->filhos[i];
+        pai->contagens[i+1] = pai->contagens[i];
+        if(arv->capacidadeBuffer > 0) pai->pendentes[i+1] = pai->pendentes[i];
     }
 
     // faz as inserções nos espaços corretos do nó pai
@@ -381,6 +1549,12 @@ static void splitNodeFilho(ArvB* arv, Node* pai, Node* filho, int idxFilho) {
     pai->registros[idxFilho] = filho->registros[idxMediana];
     pai->filhos[idxFilho] = filho->posicaoArqBin;
     pai->filhos[idxFilho + 1] = segundoFilho->posicaoArqBin;
+    pai->contagens[idxFilho] = totalChavesNode(filho);
+    pai->contagens[idxFilho + 1] = totalChavesNode(segundoFilho);
+    if(arv->capacidadeBuffer > 0) {
+        pai->pendentes[idxFilho] = totalPendentes(filho);
+        pai->pendentes[idxFilho + 1] = totalPendentes(segundoFilho);
+    }
 
     pai->numChavesArmazenadas++;
 
@@ -394,7 +1568,7 @@ static void splitNodeFilho(ArvB* arv, Node* pai, Node* filho, int idxFilho) {
     escreveNodeArqBin(arv, filho);
     escreveNodeArqBin(arv, segundoFilho);
 
-    liberaNode(segundoFilho);
+    liberaNode(arv, segundoFilho);
 }
 
 // Retorna o mínimo de chaves permitido para um nó interno
@@ -433,19 +1607,19 @@ static void rebalanceia(ArvB* arv, Node* pai, Node* filho, int idxFilho){
         Node* irmao = leNodeArqBin(pai->filhos[idxFilho-1], arv); // lê irmão adjacente à esquerda
         if(irmao->numChavesArmazenadas > minChaves(arv->ordem)) { // verifica se a redistribuição é possível
             redistribuiDaEsquerda(arv, pai, idxFilho, filho, irmao);
-            liberaNode(irmao);
+            liberaNode(arv, irmao);
             return;
         }
-        liberaNode(irmao);
+        liberaNode(arv, irmao);
     } 
     if (idxFilho < pai->numChavesArmazenadas) { // nó filho tem irmão à direita
         Node* irmao = leNodeArqBin(pai->filhos[idxFilho+1], arv); // lê irmão adjacente à direita
         if(irmao->numChavesArmazenadas > minChaves(arv->ordem)) { // verifica se a redistribuição é possível
             redistribuiDaDireita(arv, pai, idxFilho, filho, irmao);
-            liberaNode(irmao);
+            liberaNode(arv, irmao);
             return; 
         }
-        liberaNode(irmao);
+        liberaNode(arv, irmao);
     }
 
     // Se não foi possível realizar a redistribuição com nenhum irmão adjacente, realiza-se o procedimento de concatenação
@@ -456,12 +1630,12 @@ static void rebalanceia(ArvB* arv, Node* pai, Node* filho, int idxFilho){
         if(pai->numChavesArmazenadas < minChaves(arv->ordem)) pai->ehMiniNode = TRUE;
         
         if (pai->posicaoArqBin == POSICAO_RAIZ && pai->numChavesArmazenadas == 0) { // se o pai era a raíz e ficou vazio, o irmão vira a nova raíz
-            arv->numNos--;
+            liberaSlot(arv, irmao->posicaoArqBin);
             irmao->posicaoArqBin = POSICAO_RAIZ;
             escreveNodeArqBin(arv, irmao);
         }
 
-        liberaNode(irmao);
+        liberaNode(arv, irmao);
         return;
     } else {
         Node* irmao = leNodeArqBin(pai->filhos[idxFilho+1], arv);
@@ -469,12 +1643,12 @@ static void rebalanceia(ArvB* arv, Node* pai, Node* filho, int idxFilho){
         if(pai->numChavesArmazenadas < minChaves(arv->ordem)) pai->ehMiniNode = TRUE;
 
         if (pai->posicaoArqBin == POSICAO_RAIZ && pai->numChavesArmazenadas == 0) {
-            arv->numNos--;
+            liberaSlot(arv, filho->posicaoArqBin);
             filho->posicaoArqBin = POSICAO_RAIZ;
             escreveNodeArqBin(arv, filho);
         }
 
-        liberaNode(irmao);
+        liberaNode(arv, irmao);
         return;
     }
 }
@@ -484,12 +1658,17 @@ static void rebalanceia(ArvB* arv, Node* pai, Node* filho, int idxFilho){
 static int trocaChaveComPredecessor(ArvB* arv, Node* pai, Node* filho, int idxChave) {
 
     // busca o node mais a direita da subárvore enraizada em ant
+    // (os nós intermediários são devolvidos à árvore; 'filho' pertence ao chamador)
     Node* predecessor = filho;
-    while (!predecessor->ehFolha)
-        predecessor = leNodeArqBin(predecessor->filhos[predecessor->numChavesArmazenadas], arv);
+    while (!predecessor->ehFolha) {
+        Node* proximo = leNodeArqBin(predecessor->filhos[predecessor->numChavesArmazenadas], arv);
+        if(predecessor != filho) liberaNode(arv, predecessor);
+        predecessor = proximo;
+    }
             
     int novaChave = predecessor->chaves[predecessor->numChavesArmazenadas - 1];
     int novoRegistro = predecessor->registros[predecessor->numChavesArmazenadas - 1];
+    if(predecessor != filho) liberaNode(arv, predecessor);
     
     // substituição de dados
     pai->chaves[idxChave] =  novaChave;
@@ -500,37 +1679,44 @@ static int trocaChaveComPredecessor(ArvB* arv, Node* pai, Node* filho, int idxCh
     return novaChave;
 }
 
-// Implementa a remoção recursiva pela árvore a partir do nó de entrada.
-static void removeChaveValorRec(ArvB* arv, Node* n, int chave) {
+// Implementa a remoção recursiva pela árvore a partir do nó de entrada. Retorna 1 se a chave foi removida (copiando o seu
+// registro para 'registroRemovido', se não for NULL) e 0 se ela não estava na árvore.
+static int removeChaveValorRec(ArvB* arv, Node* n, int chave, int* registroRemovido) {
     int idx = buscaBinaria(chave, n->chaves, 0, n->numChavesArmazenadas - 1);
 
     if(idx == n->numChavesArmazenadas || n->chaves[idx] != chave) { // verifica se a chave a ser removida foi encontrada
         
-        if(n->ehFolha) return; // chave não está na árvore
+        if(n->ehFolha) return FALSE; // chave não está na árvore
 
         Node* filho = leNodeArqBin(n->filhos[idx], arv);
-        removeChaveValorRec(arv, filho, chave);
+        int removida = removeChaveValorRec(arv, filho, chave, registroRemovido);
+        if(removida) n->contagens[idx]--; // a subárvore perdeu uma chave
         
         if(filho->ehMiniNode) { // verifica se o filho se tornou mini node (possui menos chaves que o permitido)
             rebalanceia(arv, n, filho, idx);
+        } else if(removida) {
+            escreveNodeArqBin(arv, n);
         }
-        liberaNode(filho);
+        liberaNode(arv, filho);
+        return removida;
     } else { // chave encontrada no nó atual
+        if(registroRemovido != NULL) *registroRemovido = n->registros[idx];
         if(n->ehFolha) {
             removeFolha(arv, n, idx);
         } else {
             Node* filho = leNodeArqBin(n->filhos[idx], arv);            
 
+            n->contagens[idx]--; // o predecessor sai da subárvore do filho (gravado junto com a troca)
             int chavePred = trocaChaveComPredecessor(arv, n, filho, idx);
-            removeChaveValorRec(arv, filho, chavePred);
+            removeChaveValorRec(arv, filho, chavePred, NULL);
 
             if(filho->ehMiniNode) { // verifica se o filho se tornou mini node (possui menos chaves que o permitido)
                 rebalanceia(arv, n, filho, idx);
             }
-            liberaNode(filho);
+            liberaNode(arv, filho);
         }
+        return TRUE;
     }
-
 }
 
 static void redistribuiDaEsquerda(ArvB* arv, Node* pai, int idxFilho, Node* filho, Node* irmaoEsq) {
@@ -545,6 +1731,7 @@ static void redistribuiDaEsquerda(ArvB* arv, Node* pai, int idxFilho, Node* filh
     if(!filho->ehFolha){
         for(int i = filho->numChavesArmazenadas; i >= 0; i--){
             filho->filhos[i+1] = filho->filhos[i];
+            filho->contagens[i+1] = filho->contagens[i];
         }
     }
 
@@ -555,6 +1742,7 @@ static void redistribuiDaEsquerda(ArvB* arv, Node* pai, int idxFilho, Node* filh
     // Move último filho do irmão para o primeiro do filho
     if(!filho->ehFolha) {
         filho->filhos[0] = irmaoEsq->filhos[irmaoEsq->numChavesArmazenadas];
+        filho->contagens[0] = irmaoEsq->contagens[irmaoEsq->numChavesArmazenadas];
     }
 
     // Atualiza a chave do pai com a última chave do irmão esquerdo
@@ -564,6 +1752,9 @@ static void redistribuiDaEsquerda(ArvB* arv, Node* pai, int idxFilho, Node* filh
     filho->numChavesArmazenadas++;
     irmaoEsq->numChavesArmazenadas--;
 
+    pai->contagens[idxFilho - 1] = totalChavesNode(irmaoEsq);
+    pai->contagens[idxFilho] = totalChavesNode(filho);
+
     escreveNodeArqBin(arv, pai);
     escreveNodeArqBin(arv, filho);
     escreveNodeArqBin(arv, irmaoEsq);
@@ -588,13 +1779,18 @@ static void redistribuiDaDireita(ArvB* arv, Node* pai, int idxFilho, Node* filho
     // Move o primeiro filho do irmão direito (se não for folha)
     if (!irmaoDir->ehFolha) {
         filho->filhos[filho->numChavesArmazenadas] = irmaoDir->filhos[0];
-        for (int i = 0; i < irmaoDir->numChavesArmazenadas - 1; i++) {
+        filho->contagens[filho->numChavesArmazenadas] = irmaoDir->contagens[0];
+        for (int i = 0; i < irmaoDir->numChavesArmazenadas; i++) {
             irmaoDir->filhos[i] = irmaoDir->filhos[i + 1];
+            irmaoDir->contagens[i] = irmaoDir->contagens[i + 1];
         }
     }
 
     irmaoDir->numChavesArmazenadas--;
 
+    pai->contagens[idxFilho] = totalChavesNode(filho);
+    pai->contagens[idxFilho + 1] = totalChavesNode(irmaoDir);
+
     escreveNodeArqBin(arv, pai);
     escreveNodeArqBin(arv, filho);
     escreveNodeArqBin(arv, irmaoDir);
@@ -616,6 +1812,7 @@ static void concatenaComIrmaoEsquerdo(ArvB* arv, Node* pai, int idxFilho, Node*
     if (!irmaoEsq->ehFolha) {
         for (int i = 0; i <= filho->numChavesArmazenadas; i++) {
             irmaoEsq->filhos[irmaoEsq->numChavesArmazenadas + i] = filho->filhos[i];
+            irmaoEsq->contagens[irmaoEsq->numChavesArmazenadas + i] = filho->contagens[i];
         }
     }
     irmaoEsq->numChavesArmazenadas += filho->numChavesArmazenadas;
@@ -627,15 +1824,407 @@ static void concatenaComIrmaoEsquerdo(ArvB* arv, Node* pai, int idxFilho, Node*
     }
     for (int i = idxFilho; i < pai->numChavesArmazenadas; i++) {
         pai->filhos[i] = pai->filhos[i + 1];
+        pai->contagens[i] = pai->contagens[i + 1];
     }
 
     pai->numChavesArmazenadas--;
+    pai->contagens[idxFilho - 1] = totalChavesNode(irmaoEsq);
 
     if(irmaoEsq->ehMiniNode == TRUE) irmaoEsq->ehMiniNode = FALSE;
 
     escreveNodeArqBin(arv, pai);
     escreveNodeArqBin(arv, irmaoEsq);
 
-    arv->numNos--;
+    liberaSlot(arv, filho->posicaoArqBin);
+}
+
+// Retorna a altura da árvore (0 se a raíz for folha); todas as folhas estão na mesma profundidade
+static int alturaArvB(ArvB* arv) {
+    int altura = 0;
+    Node* n = leNodeArqBin(POSICAO_RAIZ, arv);
+    while(!n->ehFolha) {
+        Node* proximo = leNodeArqBin(n->filhos[0], arv);
+        liberaNode(arv, n);
+        n = proximo;
+        altura++;
+    }
+    liberaNode(arv, n);
+    return altura;
+}
+
+// Descarta uma subárvore inteira, liberando as posições dos seus nós. Apenas os nós internos são lidos (para chegar aos
+// filhos), exceto com o filtro de pertinência habilitado, quando as folhas também são lidas para retirar as suas chaves.
+static void liberaSubarvore(ArvB* arv, int posNode, int altura) {
+    liberaSlot(arv, posNode);
+    if(altura == 0 && arv->filtro == NULL) return;
+
+    Node* n = leNodeArqBin(posNode, arv);
+    for(int i = 0; i < n->numChavesArmazenadas; i++) {
+        removeFiltro(arv->filtro, n->chaves[i]);
+    }
+    for(int i = 0; altura > 0 && i <= n->numChavesArmazenadas; i++) {
+        liberaSubarvore(arv, n->filhos[i], altura-1);
+    }
+    liberaNode(arv, n);
+}
+
+// Retira da subárvore do nó as chaves em [chaveMin, chaveMax], sabendo que as suas chaves estão em (limInf, limSup).
+// Os filhos inteiramente cobertos pelo intervalo são descartados sem passar pelas suas chaves; apenas os (no máximo dois)
+// filhos cortados pelos extremos são visitados, de forma que a descida segue só os dois caminhos de fronteira. Retorna a
+// subárvore que sobra, que pode ficar mais baixa. No nó em que os caminhos se separam, a última chave do intervalo é
+// mantida como separadora entre as duas subárvores cortadas e informada em 'separador', para ser removida depois.
+// 'numRemovidas' acumula as chaves retiradas (inclusive a separadora), usando as contagens das subárvores descartadas.
+static Subarvore removeIntervaloRec(ArvB* arv, int posNode, int altura, int chaveMin, int chaveMax, long long limInf,
+                                    long long limSup, int* separador, int* registroSeparador, int* numRemovidas) {
+    Node* n = leNodeArqBin(posNode, arv);
+    int num = n->numChavesArmazenadas;
+
+    // chaves[i..j-1] estão no intervalo
+    int i = buscaBinaria(chaveMin, n->chaves, 0, num-1);
+    int j = buscaBinaria(chaveMax, n->chaves, 0, num-1);
+    if(j < num && n->chaves[j] == chaveMax) j++;
+
+    Subarvore sub = {.posicao = -1, .altura = -1, .numChaves = 0};
+    if(n->ehFolha) {
+        if(i == j) { // nada a retirar
+            sub = (Subarvore){posNode, 0, num};
+            liberaNode(arv, n);
+            return sub;
+        }
+
+        for(int k = i; k < j; k++) {
+            removeFiltro(arv->filtro, n->chaves[k]);
+        }
+        *numRemovidas += j - i;
+        for(int k = j; k < num; k++) {
+            n->chaves[k - (j-i)] = n->chaves[k];
+            n->registros[k - (j-i)] = n->registros[k];
+        }
+        n->numChavesArmazenadas -= j - i;
+
+        if(n->numChavesArmazenadas == 0) { // folha esvaziada
+            liberaSlot(arv, posNode);
+        } else {
+            escreveNodeArqBin(arv, n);
+            sub = (Subarvore){posNode, 0, n->numChavesArmazenadas};
+        }
+        liberaNode(arv, n);
+        return sub;
+    }
+
+    // os filhos entre 'i' e 'j' cujas chaves estão todas no intervalo são descartados; os demais são cortados
+    Subarvore subEsq = sub, subDir = sub;
+    int cortaEsq = FALSE, cortaDir = FALSE;
+    for(int k = i; k <= j; k++) {
+        long long inf = k > 0 ? n->chaves[k-1] : limInf;
+        long long sup = k < num ? n->chaves[k] : limSup;
+        if(inf >= (long long)chaveMin - 1 && sup <= (long long)chaveMax + 1) {
+            liberaSubarvore(arv, n->filhos[k], altura-1);
+            *numRemovidas += n->contagens[k];
+        } else if(k == i) {
+            subEsq = removeIntervaloRec(arv, n->filhos[k], altura-1, chaveMin, chaveMax, inf, sup, separador,
+                                        registroSeparador, numRemovidas);
+            cortaEsq = TRUE;
+        } else {
+            subDir = removeIntervaloRec(arv, n->filhos[k], altura-1, chaveMin, chaveMax, inf, sup, separador,
+                                        registroSeparador, numRemovidas);
+            cortaDir = TRUE;
+        }
+    }
+
+    sub = cortaEsq ? subEsq : subDir;
+    int numRetiradas = j - i;
+    *numRemovidas += numRetiradas;
+    if(cortaEsq && cortaDir) { // os caminhos se separam aqui: as duas partes são juntadas pela última chave do intervalo
+        *separador = n->chaves[j-1];
+        *registroSeparador = n->registros[j-1];
+        sub = juntaSubarvores(arv, subEsq, n->chaves[j-1], n->registros[j-1], subDir);
+        numRetiradas--;
+    }
+    for(int k = i; k < i + numRetiradas; k++) {
+        removeFiltro(arv->filtro, n->chaves[k]);
+    }
+
+    // sobram chaves[0..i-1] e chaves[j..], com a subárvore cortada no lugar dos filhos i..j
+    for(int k = j; k < num; k++) {
+        n->chaves[k - (j-i)] = n->chaves[k];
+        n->registros[k - (j-i)] = n->registros[k];
+    }
+    for(int k = j+1; k <= num; k++) {
+        n->filhos[k - (j-i)] = n->filhos[k];
+        n->contagens[k - (j-i)] = n->contagens[k];
+    }
+    n->numChavesArmazenadas -= j - i;
+
+    return encaixaSubarvore(arv, n, altura, i, sub);
+}
+
+// Coloca a subárvore no lugar do filho 'idx' do nó (de altura 'altura'), corrigindo o que o corte deixou fora do padrão:
+// uma subárvore baixa demais é juntada a um filho vizinho, uma que cresceu tem a sua raíz incorporada ao nó e uma raíz
+// com poucas chaves é equilibrada com o irmão. Libera o nó e retorna a subárvore resultante, sem a raíz se ela ficar
+// sem chaves.
+static Subarvore encaixaSubarvore(ArvB* arv, Node* n, int altura, int idx, Subarvore sub) {
+    if(n->numChavesArmazenadas == 0 && sub.altura < altura) { // não sobrou nada no nó além da subárvore
+        liberaSlot(arv, n->posicaoArqBin);
+        liberaNode(arv, n);
+        return sub;
+    }
+
+    if(sub.altura < altura - 1) {
+        if(idx > 0) { // junta com o irmão esquerdo, que perde a chave que os separava
+            Subarvore irmao = {n->filhos[idx-1], altura-1, n->contagens[idx-1]};
+            sub = juntaSubarvores(arv, irmao, n->chaves[idx-1], n->registros[idx-1], sub);
+            for(int k = idx; k < n->numChavesArmazenadas; k++) {
+                n->chaves[k-1] = n->chaves[k];
+                n->registros[k-1] = n->registros[k];
+                n->filhos[k] = n->filhos[k+1];
+                n->contagens[k] = n->contagens[k+1];
+            }
+            idx--;
+        } else { // junta com o irmão direito
+            Subarvore irmao = {n->filhos[idx+1], altura-1, n->contagens[idx+1]};
+            sub = juntaSubarvores(arv, sub, n->chaves[idx], n->registros[idx], irmao);
+            for(int k = idx+1; k < n->numChavesArmazenadas; k++) {
+                n->chaves[k-1] = n->chaves[k];
+                n->registros[k-1] = n->registros[k];
+                n->filhos[k] = n->filhos[k+1];
+                n->contagens[k] = n->contagens[k+1];
+            }
+        }
+        n->numChavesArmazenadas--;
+    }
+
+    if(sub.altura == altura) { // a junção cresceu: a sua raíz (uma chave e dois filhos) é incorporada ao nó
+        Node* raizSub = leNodeArqBin(sub.posicao, arv);
+        for(int k = n->numChavesArmazenadas; k > idx; k--) {
+            n->chaves[k] = n->chaves[k-1];
+            n->registros[k] = n->registros[k-1];
+            n->filhos[k+1] = n->filhos[k];
+            n->contagens[k+1] = n->contagens[k];
+        }
+        n->chaves[idx] = raizSub->chaves[0];
+        n->registros[idx] = raizSub->registros[0];
+        n->filhos[idx] = raizSub->filhos[0];
+        n->filhos[idx+1] = raizSub->filhos[1];
+        n->contagens[idx] = raizSub->contagens[0];
+        n->contagens[idx+1] = raizSub->contagens[1];
+        n->numChavesArmazenadas++;
+        liberaSlot(arv, raizSub->posicaoArqBin);
+        liberaNode(arv, raizSub);
+        escreveNodeArqBin(arv, n);
+    } else {
+        n->filhos[idx] = sub.posicao;
+        n->contagens[idx] = sub.numChaves;
+        if(n->numChavesArmazenadas > 0 && !equilibraFilhos(arv, n, idx > 0 ? idx-1 : idx)) escreveNodeArqBin(arv, n);
+    }
+
+    Subarvore resultado = {n->posicaoArqBin, altura, totalChavesNode(n)};
+    if(n->numChavesArmazenadas == 0) { // restou apenas um filho, que passa a ser o resultado
+        resultado = (Subarvore){n->filhos[0], altura-1, n->contagens[0]};
+        liberaSlot(arv, n->posicaoArqBin);
+    }
+    liberaNode(arv, n);
+    return resultado;
 }
-// ---
\ No newline at end of file
+
+// Junta duas subárvores e a chave entre elas (todas as chaves de 'esq' são menores que 'chave', e as de 'dir', maiores).
+// A mais baixa é pendurada na borda da mais alta, no nível correspondente, e apenas os nós dessa borda são modificados;
+// o resultado tem a altura da mais alta ou uma a mais.
+static Subarvore juntaSubarvores(ArvB* arv, Subarvore esq, int chave, int registro, Subarvore dir) {
+    Subarvore resultado = {.numChaves = esq.numChaves + 1 + dir.numChaves};
+
+    if(esq.altura == dir.altura) { // nova raíz com a chave e as duas subárvores (uma folha, se ambas forem vazias)
+        Node* raiz = criaNode(arv, esq.altura < 0, alocaSlot(arv));
+        raiz->numChavesArmazenadas = 1;
+        raiz->chaves[0] = chave;
+        raiz->registros[0] = registro;
+        if(esq.altura >= 0) {
+            raiz->filhos[0] = esq.posicao;
+            raiz->filhos[1] = dir.posicao;
+            raiz->contagens[0] = esq.numChaves;
+            raiz->contagens[1] = dir.numChaves;
+        }
+        if(raiz->ehFolha || !equilibraFilhos(arv, raiz, 0)) escreveNodeArqBin(arv, raiz);
+
+        resultado.posicao = raiz->posicaoArqBin;
+        resultado.altura = esq.altura + 1;
+        if(raiz->numChavesArmazenadas == 0) { // as duas raízes couberam em um único nó
+            resultado.posicao = raiz->filhos[0];
+            resultado.altura = esq.altura;
+            liberaSlot(arv, raiz->posicaoArqBin);
+        }
+        liberaNode(arv, raiz);
+        return resultado;
+    }
+
+    int naDireita = esq.altura > dir.altura;
+    Subarvore maior = naDireita ? esq : dir;
+    Node* raiz = leNodeArqBin(maior.posicao, arv);
+    insereNaBorda(arv, raiz, maior.altura, chave, registro, naDireita ? dir : esq, naDireita);
+
+    resultado.posicao = maior.posicao;
+    resultado.altura = maior.altura;
+    if(raiz->ehSuperNode) { // a raíz é splitada em um novo nó acima dela
+        Node* novaRaiz = criaNode(arv, FALSE, alocaSlot(arv));
+        novaRaiz->filhos[0] = raiz->posicaoArqBin;
+        splitNodeFilho(arv, novaRaiz, raiz, 0);
+
+        resultado.posicao = novaRaiz->posicaoArqBin;
+        resultado.altura++;
+        liberaNode(arv, novaRaiz);
+    }
+    liberaNode(arv, raiz);
+    return resultado;
+}
+
+// Desce pela borda direita (ou esquerda) da subárvore do nó até o nível logo acima da subárvore fornecida e a pendura ali
+// como último (ou primeiro) filho, junto com a chave. Os nós da borda que viram super node são splitados na volta; se o
+// próprio nó virar super node, o split fica a cargo do chamador.
+static void insereNaBorda(ArvB* arv, Node* n, int altura, int chave, int registro, Subarvore sub, int naDireita) {
+    int num = n->numChavesArmazenadas;
+
+    if(altura > sub.altura + 1) {
+        int idx = naDireita ? num : 0;
+        Node* filho = leNodeArqBin(n->filhos[idx], arv);
+        insereNaBorda(arv, filho, altura-1, chave, registro, sub, naDireita);
+
+        if(filho->ehSuperNode) {
+            splitNodeFilho(arv, n, filho, idx); // recalcula as contagens dos dois filhos e grava o nó
+        } else {
+            n->contagens[idx] = totalChavesNode(filho);
+            escreveNodeArqBin(arv, n);
+        }
+        liberaNode(arv, filho);
+        return;
+    }
+
+    if(naDireita) {
+        n->chaves[num] = chave;
+        n->registros[num] = registro;
+        if(sub.altura >= 0) {
+            n->filhos[num+1] = sub.posicao;
+            n->contagens[num+1] = sub.numChaves;
+        }
+    } else {
+        for(int k = num; k > 0; k--) {
+            n->chaves[k] = n->chaves[k-1];
+            n->registros[k] = n->registros[k-1];
+        }
+        for(int k = num+1; sub.altura >= 0 && k > 0; k--) {
+            n->filhos[k] = n->filhos[k-1];
+            n->contagens[k] = n->contagens[k-1];
+        }
+        n->chaves[0] = chave;
+        n->registros[0] = registro;
+        if(sub.altura >= 0) {
+            n->filhos[0] = sub.posicao;
+            n->contagens[0] = sub.numChaves;
+        }
+    }
+    n->numChavesArmazenadas++;
+
+    // a raíz da subárvore pendurada pode ter menos chaves que o mínimo
+    int equilibrado = sub.altura >= 0 && equilibraFilhos(arv, n, naDireita ? num : 0);
+    if(n->numChavesArmazenadas == arv->ordem) {
+        n->ehSuperNode = TRUE;
+    } else if(!equilibrado) {
+        escreveNodeArqBin(arv, n);
+    }
+}
+
+// Corrige o par de filhos adjacentes 'idxEsq' e 'idxEsq'+1 quando algum deles tem menos chaves que o mínimo, com qualquer
+// deficit (rebalanceia cobre apenas o de uma chave): concatena os dois se couberem em um nó ou divide as chaves igualmente
+// entre eles. Retorna 1 se o par foi corrigido (e o pai gravado) e 0 se nada foi preciso.
+static int equilibraFilhos(ArvB* arv, Node* pai, int idxEsq) {
+    Node* esq = leNodeArqBin(pai->filhos[idxEsq], arv);
+    Node* dir = leNodeArqBin(pai->filhos[idxEsq+1], arv);
+    int minimo = minChaves(arv->ordem);
+
+    int corrigido = esq->numChavesArmazenadas < minimo || dir->numChavesArmazenadas < minimo;
+    if(corrigido) {
+        if(esq->numChavesArmazenadas + dir->numChavesArmazenadas + 1 <= arv->ordem - 1) {
+            concatenaComIrmaoEsquerdo(arv, pai, idxEsq+1, dir, esq);
+        } else {
+            redistribuiUniforme(arv, pai, idxEsq, esq, dir);
+        }
+    }
+
+    liberaNode(arv, esq);
+    liberaNode(arv, dir);
+    return corrigido;
+}
+
+// Divide igualmente entre os dois irmãos as suas chaves e a chave separadora do pai (com os respectivos filhos). As
+// chaves passam diretamente de um irmão para o outro através do pai, sem vetores auxiliares.
+static void redistribuiUniforme(ArvB* arv, Node* pai, int idxEsq, Node* esq, Node* dir) {
+    int numEsq = (esq->numChavesArmazenadas + dir->numChavesArmazenadas) / 2;
+
+    if(esq->numChavesArmazenadas < numEsq) { // 'd' chaves passam do direito para o esquerdo
+        int d = numEsq - esq->numChavesArmazenadas;
+        int n = esq->numChavesArmazenadas;
+
+        // a separadora desce para o esquerdo, seguida das d-1 primeiras chaves do direito; a d-ésima sobe para o pai
+        esq->chaves[n] = pai->chaves[idxEsq];
+        esq->registros[n] = pai->registros[idxEsq];
+        for(int k = 0; k < d-1; k++) {
+            esq->chaves[n+1+k] = dir->chaves[k];
+            esq->registros[n+1+k] = dir->registros[k];
+        }
+        pai->chaves[idxEsq] = dir->chaves[d-1];
+        pai->registros[idxEsq] = dir->registros[d-1];
+        for(int k = d; k < dir->numChavesArmazenadas; k++) {
+            dir->chaves[k-d] = dir->chaves[k];
+            dir->registros[k-d] = dir->registros[k];
+        }
+
+        if(!esq->ehFolha) {
+            for(int k = 0; k < d; k++) {
+                esq->filhos[n+1+k] = dir->filhos[k];
+                esq->contagens[n+1+k] = dir->contagens[k];
+            }
+            for(int k = d; k <= dir->numChavesArmazenadas; k++) {
+                dir->filhos[k-d] = dir->filhos[k];
+                dir->contagens[k-d] = dir->contagens[k];
+            }
+        }
+        esq->numChavesArmazenadas += d;
+        dir->numChavesArmazenadas -= d;
+    } else if(esq->numChavesArmazenadas > numEsq) { // 'd' chaves passam do esquerdo para o direito
+        int d = esq->numChavesArmazenadas - numEsq;
+
+        for(int k = dir->numChavesArmazenadas-1; k >= 0; k--) {
+            dir->chaves[k+d] = dir->chaves[k];
+            dir->registros[k+d] = dir->registros[k];
+        }
+        // a separadora desce para o direito, precedida das d-1 últimas chaves do esquerdo; a anterior a elas sobe
+        dir->chaves[d-1] = pai->chaves[idxEsq];
+        dir->registros[d-1] = pai->registros[idxEsq];
+        for(int k = 0; k < d-1; k++) {
+            dir->chaves[k] = esq->chaves[numEsq+1+k];
+            dir->registros[k] = esq->registros[numEsq+1+k];
+        }
+        pai->chaves[idxEsq] = esq->chaves[numEsq];
+        pai->registros[idxEsq] = esq->registros[numEsq];
+
+        if(!esq->ehFolha) {
+            for(int k = dir->numChavesArmazenadas; k >= 0; k--) {
+                dir->filhos[k+d] = dir->filhos[k];
+                dir->contagens[k+d] = dir->contagens[k];
+            }
+            for(int k = 0; k < d; k++) {
+                dir->filhos[k] = esq->filhos[numEsq+1+k];
+                dir->contagens[k] = esq->contagens[numEsq+1+k];
+            }
+        }
+        esq->numChavesArmazenadas -= d;
+        dir->numChavesArmazenadas += d;
+    }
+
+    pai->contagens[idxEsq] = totalChavesNode(esq);
+    pai->contagens[idxEsq + 1] = totalChavesNode(dir);
+
+    escreveNodeArqBin(arv, pai);
+    escreveNodeArqBin(arv, esq);
+    escreveNodeArqBin(arv, dir);
+}
+// ---
@@ -14,12 +14,105 @@
 /// inteiros positivos de chave.
 typedef struct _arvB ArvB;
 
+/// @brief Função chamada para cada par chave/registro visitado em um percurso da árvore.
+typedef void (*VisitaChave)(int chave, int registro, void* contexto);
+
 /// @brief Cria uma árvore vazia.
 /// @param ordem Ordem da árvore
 /// @return Ponteiro para a estrutura da árvore alocada dinamicamente.
 ArvB* criaArvB(int ordem);
 
+/// @brief Cria uma árvore vazia cuja ordem é derivada do tamanho de página desejado para cada nó. Cada nó passa a ocupar
+/// exatamente uma página no arquivo binário, de forma que os nós ficam alinhados às fronteiras de página.
+/// @param tamPaginaBytes Tamanho, em bytes, da página de cada nó (ex.: 4096, 16384, 65536)
+/// @return Ponteiro para a estrutura da árvore alocada dinamicamente ou NULL se a página não comportar um nó de ordem 3.
+ArvB* criaArvBPagina(int tamPaginaBytes);
+
+/// @brief Cria uma árvore vazia mantida inteiramente na memória principal: os nós ficam em uma arena contígua de slots de
+/// tamanho fixo, alinhados à linha de cache e endereçados pela posição do nó, sem nenhum arquivo binário. As operações têm
+/// a mesma semântica da árvore mantida em arquivo.
+/// @param ordem Ordem da árvore
+/// @return Ponteiro para a estrutura da árvore alocada dinamicamente.
+ArvB* criaArvBMemoria(int ordem);
+
+/// @brief Salva um retrato da árvore (cabeçalho e todos os nós) no arquivo fornecido, que pode ser recarregado com carregaArvB.
+/// O filtro de pertinência, se habilitado, é salvo em '<nomeArq>.filtro'; caso contrário, esse arquivo é apagado. Se
+/// alguma gravação falhar, os arquivos incompletos são apagados.
+/// @param arv Ponteiro para a árvore B
+/// @param nomeArq Caminho do arquivo do retrato
+/// @return 1 se o retrato foi salvo e 0, caso contrário.
+int salvaArvB(ArvB* arv, const char* nomeArq);
+
+/// @brief Recria, na memória principal (como em criaArvBMemoria), uma árvore salva com salvaArvB. O cabeçalho (número
+/// mágico, versão do formato e campos) e o tamanho do arquivo são validados antes da leitura dos nós.
+/// @param nomeArq Caminho do arquivo do retrato
+/// @return Ponteiro para a estrutura da árvore alocada dinamicamente ou NULL se o arquivo não puder ser lido, não for um
+/// retrato válido, estiver truncado ou se o filtro salvo junto não puder ser lido.
+ArvB* carregaArvB(const char* nomeArq);
+
+/// @brief Calcula a maior ordem cujo nó (chaves, registros e filhos) cabe em uma página do tamanho fornecido.
+/// @param tamPaginaBytes Tamanho da página em bytes
+/// @return A ordem calculada ou -1 se a página não comportar um nó de ordem 3.
+int ordemPorTamPagina(int tamPaginaBytes);
+
+/// @brief Define o nome do arquivo binário utilizado pela árvore (por padrão, "arvB.bin"). Só é possível enquanto o arquivo
+/// ainda não tiver sido criado, ou seja, antes da primeira inserção.
+/// @param arv Ponteiro para a árvore B
+/// @param nomeArqBin Caminho do arquivo binário
+/// @return 1 se o nome foi definido e 0, caso contrário.
+int defineArqBinArvB(ArvB* arv, const char* nomeArqBin);
+
+/// @brief Faz cada acesso a nó chegar ao dispositivo: cada página gravada é sincronizada (fdatasync) e as páginas lidas ou
+/// gravadas são retiradas do cache do sistema operacional (posix_fadvise). Ao habilitar, o arquivo binário já existente
+/// também é sincronizado e retirado do cache. Voltado às medições de desempenho, em que o cache mascararia o disco.
+/// @param arv Ponteiro para a árvore B
+/// @param acessoDireto 1 para habilitar e 0 para desabilitar
+/// @return 1 se a opção foi definida e 0, caso contrário (árvore mantida em memória).
+int defineAcessoDiretoArvB(ArvB* arv, int acessoDireto);
+
+/// @brief Retorna a ordem da árvore.
+/// @param arv Ponteiro para a árvore B
+/// @return Ordem da árvore ou -1 se a árvore for NULL.
+int getOrdemArvB(ArvB* arv);
+
+/// @brief Habilita um filtro de pertinência (filtro de Bloom com contadores) mantido nas inserções e remoções e consultado
+/// antes de cada busca: quando o filtro garante que a chave não está na árvore, a busca termina sem ler nenhum nó. O filtro
+/// é salvo e recarregado junto com os retratos de salvaArvB/carregaArvB. Só é possível enquanto a árvore estiver vazia.
+/// @param arv Ponteiro para a árvore B
+/// @param numChavesEsperadas Número de chaves que se espera armazenar na árvore
+/// @param taxaFalsoPositivo Taxa de falsos positivos desejada (entre 0 e 1, exclusive)
+/// @return 1 se o filtro foi habilitado e 0, caso contrário.
+int habilitaFiltroArvB(ArvB* arv, int numChavesEsperadas, double taxaFalsoPositivo);
+
+/// @brief Habilita o modo bufferizado (árvore B-epsilon): cada nó interno reserva espaço para um buffer de mensagens.
+/// Inserções, atualizações e remoções viram mensagens no buffer da raíz e só descem um nível quando o buffer enche, em um
+/// lote destinado ao filho que recebe mais mensagens; assim, cada escrita de nó é amortizada por várias operações. As
+/// buscas consideram as mensagens pendentes pelo caminho; insereSeAusente, comparaETroca, acumulaRegistro e removeERetorna
+/// fazem uma busca pelo registro atual e registram o resultado como mensagem. Em árvores criadas por tamanho de página, o
+/// buffer ocupa parte da página e a ordem é reduzida. Nesse modo, o registro INT_MIN é reservado (marca chaves apagadas),
+/// e a impressão, o percurso por intervalo e as estatísticas de ordem consolidam a árvore antes (ver
+/// descarregaBuffersArvB). Só é possível enquanto a árvore estiver vazia e sem filtro de pertinência.
+/// @param arv Ponteiro para a árvore B
+/// @param capacidadeBuffer Número de mensagens do buffer de cada nó interno
+/// @return 1 se o modo foi habilitado e 0, caso contrário.
+int habilitaBufferArvB(ArvB* arv, int capacidadeBuffer);
+
+/// @brief Consolida a árvore no modo bufferizado: aplica todas as mensagens pendentes e retira fisicamente as chaves
+/// apagadas. Só são lidas as subárvores com mensagens pendentes e as chaves apagadas desde a última consolidação, então
+/// o custo é proporcional às operações acumuladas, e não ao tamanho da árvore. Nada é feito fora do modo bufferizado ou
+/// se nada mudou desde a última consolidação.
+/// @param arv Ponteiro para a árvore B
+void descarregaBuffersArvB(ArvB* arv);
+
+/// @brief Informa os contadores do filtro de pertinência da árvore desde a sua criação.
+/// @param arv Ponteiro para a árvore B
+/// @param consultas Ponteiro para o número de buscas que consultaram o filtro (pode ser NULL)
+/// @param negativas Ponteiro para o número de buscas encerradas pelo filtro sem ler nenhum nó (pode ser NULL)
+/// @param falsosPositivos Ponteiro para o número de buscas liberadas pelo filtro cuja chave não estava na árvore (pode ser NULL)
+void estatisticasFiltroArvB(ArvB* arv, long* consultas, long* negativas, long* falsosPositivos);
+
 /// @brief Insere um par chave/registro na árvore. Se a chave já estiver presente, o registro é atualizado. Se a chave for negativa nada é feito.
+/// No modo bufferizado, o registro INT_MIN é reservado (marca as chaves removidas) e também é ignorado.
 /// @param arv Ponteiro para a árvore B
 /// @param chave Chave a ser inserida
 /// @param registro Registro correspondente à chave
@@ -32,11 +125,114 @@ void insereChaveValor(ArvB* arv, int chave, int registro);
 /// @return 1 se a chave for encontrada e 0, caso contrário.
 int buscaChave(ArvB* arv, int chave, int* registroBuscado);
 
+/// @brief Insere um par chave/valor em que o valor é uma sequência de bytes de tamanho arbitrário. O valor é anexado a um
+/// log de valores mantido ao lado do arquivo binário (com extensão ".vlog") e o nó guarda apenas a referência para a
+/// entrada do log, de forma que os nós não crescem com o tamanho dos valores. Se a chave já estiver presente, apenas a
+/// referência é atualizada. Os registros de uma árvore que usa valores em bytes são essas referências, portanto as duas
+/// formas de inserção não devem ser misturadas na mesma árvore.
+/// @param arv Ponteiro para a árvore B
+/// @param chave Chave a ser inserida
+/// @param valor Bytes do valor
+/// @param tamValor Tamanho do valor em bytes
+/// @return 1 se o valor foi inserido e 0, caso contrário (chave negativa ou log que passaria de INT_MAX bytes).
+int insereChaveBytes(ArvB* arv, int chave, const void* valor, int tamValor);
+
+/// @brief Busca o valor em bytes associado a uma chave, copiando no máximo 'tamMax' bytes para o endereço fornecido.
+/// @param arv Ponteiro para a árvore B
+/// @param chave Chave a ser buscada
+/// @param valor Local onde o valor deve ser copiado (pode ser NULL para consultar apenas o tamanho)
+/// @param tamMax Capacidade, em bytes, de 'valor'
+/// @return Tamanho total do valor ou -1 se a chave não for encontrada.
+int buscaChaveBytes(ArvB* arv, int chave, void* valor, int tamMax);
+
+/// @brief Recupera o espaço do log de valores ocupado por valores sobrescritos ou removidos: os valores ainda referenciados
+/// pela árvore são reescritos em um novo log e suas referências são atualizadas.
+/// @param arv Ponteiro para a árvore B
+/// @return Número de bytes recuperados.
+int compactaLogValores(ArvB* arv);
+
 /// @brief Retira par chave/valor da árvore com base na chave fornecida. Se a chave não existir nada é feito.
 /// @param arv Ponteiro para a árvore B
 /// @param chave Chave a ser removida
 void removeChaveValor(ArvB* arv, int chave);
 
+/// @brief Insere um par chave/registro apenas se a chave ainda não estiver na árvore, em uma única descida a partir da
+/// raíz. Se a chave estiver presente, nenhum nó é gravado.
+/// @param arv Ponteiro para a árvore B
+/// @param chave Chave a ser inserida
+/// @param registro Registro correspondente à chave
+/// @param registroExistente Ponteiro para o local onde o registro já presente deve ser armazenado (pode ser NULL)
+/// @return 1 se a chave foi inserida e 0 se ela já estava na árvore (ou for negativa, ou o registro for o valor
+/// INT_MIN, reservado no modo bufferizado).
+int insereSeAusente(ArvB* arv, int chave, int registro, int* registroExistente);
+
+/// @brief Substitui o registro de uma chave por 'novo' apenas se ele for igual a 'esperado', em uma única descida a partir
+/// da raíz. A chave nunca é inserida, e o nó só é gravado se o registro mudar.
+/// @param arv Ponteiro para a árvore B
+/// @param chave Chave cujo registro deve ser comparado
+/// @param esperado Registro esperado
+/// @param novo Registro que substitui o esperado
+/// @param registroAtual Ponteiro para o local onde o registro encontrado, antes da troca, deve ser armazenado (pode ser NULL)
+/// @return 1 se o registro foi trocado, 0 se ele era diferente do esperado e -1 se a chave não está na árvore (ou se
+/// 'novo' for o valor INT_MIN no modo bufferizado, em que ele é reservado e nada é feito).
+int comparaETroca(ArvB* arv, int chave, int esperado, int novo, int* registroAtual);
+
+/// @brief Soma 'incremento' ao registro de uma chave, em uma única descida a partir da raíz. Se a chave não estiver na
+/// árvore, ela é inserida com 'incremento' como registro. A soma satura em INT_MAX e em INT_MIN (INT_MIN + 1 no
+/// modo bufferizado, em que INT_MIN é reservado).
+/// @param arv Ponteiro para a árvore B
+/// @param chave Chave cujo registro deve ser acumulado
+/// @param incremento Valor somado ao registro
+/// @return O registro da chave após a soma (0 se a chave for negativa).
+int acumulaRegistro(ArvB* arv, int chave, int incremento);
+
+/// @brief Retira uma chave da árvore e informa o registro que ela possuía, na mesma descida da remoção.
+/// @param arv Ponteiro para a árvore B
+/// @param chave Chave a ser removida
+/// @param registroRemovido Ponteiro para o local onde o registro removido deve ser armazenado (pode ser NULL)
+/// @return 1 se a chave foi removida e 0 se ela não estava na árvore.
+int removeERetorna(ArvB* arv, int chave, int* registroRemovido);
+
+/// @brief Retira da árvore todas as chaves no intervalo [chaveMin, chaveMax] de uma só vez: a árvore é cortada ao longo
+/// dos caminhos até os dois extremos, as subárvores inteiramente cobertas pelo intervalo são descartadas sem que as suas
+/// chaves sejam visitadas, e a ocupação mínima dos nós é restaurada apenas ao longo desses dois caminhos. O custo é
+/// proporcional à altura da árvore mais os nós descartados (apenas os internos são lidos, ou também as folhas se houver
+/// filtro de pertinência), e não ao número de chaves removidas. No modo bufferizado, a árvore é consolidada antes.
+/// @param arv Ponteiro para a árvore B
+/// @param chaveMin Menor chave do intervalo
+/// @param chaveMax Maior chave do intervalo
+/// @return Número de chaves removidas.
+int removeIntervalo(ArvB* arv, int chaveMin, int chaveMax);
+
+/// @brief Percorre, em ordem crescente de chave, os pares chave/registro com chave no intervalo [chaveMin, chaveMax].
+/// @param arv Ponteiro para a árvore B
+/// @param chaveMin Menor chave do intervalo
+/// @param chaveMax Maior chave do intervalo
+/// @param visita Função chamada para cada par visitado
+/// @param contexto Ponteiro repassado a cada chamada de 'visita'
+void percorreIntervalo(ArvB* arv, int chaveMin, int chaveMax, VisitaChave visita, void* contexto);
+
+/// @brief Conta as chaves da árvore menores que a chave fornecida, percorrendo um único caminho a partir da raíz.
+/// @param arv Ponteiro para a árvore B
+/// @param chave Chave de referência (não precisa estar na árvore)
+/// @return Número de chaves menores que 'chave', isto é, a posição que ela ocupa (ou ocuparia) em ordem crescente.
+int rankChave(ArvB* arv, int chave);
+
+/// @brief Busca a k-ésima menor chave da árvore, percorrendo um único caminho a partir da raíz.
+/// @param arv Ponteiro para a árvore B
+/// @param k Posição da chave em ordem crescente, a partir de 0 (inverso de rankChave)
+/// @param chave Ponteiro para o local onde a chave deve ser armazenada (pode ser NULL)
+/// @param registro Ponteiro para o local onde o registro deve ser armazenado (pode ser NULL)
+/// @return 1 se a árvore possui mais de 'k' chaves e 0, caso contrário.
+int selecionaK(ArvB* arv, int k, int* chave, int* registro);
+
+/// @brief Conta as chaves no intervalo [chaveMin, chaveMax], percorrendo apenas os caminhos até os dois extremos.
+/// @param arv Ponteiro para a árvore B
+/// @param chaveMin Menor chave do intervalo
+/// @param chaveMax Maior chave do intervalo
+/// @return Número de chaves no intervalo.
+int contaIntervalo(ArvB* arv, int chaveMin, int chaveMax);
+
 /// @brief Imprime a árvore por níveis de profundidade.
 /// @param arv Ponteiro para a árvore B
 /// @param saida Referência para o local onde a impressão deve ser realizada
@@ -46,4 +242,4 @@ void imprimeArvB(ArvB* arv, FILE* saida);
 /// @param arv Ponteiro para a árvore B
 void liberaArvB(ArvB* arv);
 
-#endif
\ No newline at end of file
+#endif
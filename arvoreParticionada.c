@@ -0,0 +1,336 @@
+/**
+ * @file    arvoreParticionada.c
+ * @brief   Arquivo responsável pela implementação da árvore B particionada por intervalos de chave, com uma thread e uma
+ * fila limitada de requisições por partição.
+ * @author  Daniel Corona de Aguiar (daniel.aguiar@edu.ufes.br/2023101578)
+ * @author  João Pedro Pereira Loss (joao.loss@edu.ufes.br/2023102068)
+ * @author  Raphael Correia Dornelas (raphael.dornelas@edu.ufes.br/2023100595)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "arvoreParticionada.h"
+
+#define TRUE 1
+#define FALSE 0
+
+typedef enum {
+    INSERCAO,
+    REMOCAO,
+    BUSCA,
+    INSERCAO_SE_AUSENTE,
+    COMPARACAO_TROCA,
+    ACUMULO,
+    REMOCAO_RETORNO,
+    REMOCAO_INTERVALO,
+    PERCURSO,
+    IMPRESSAO,
+    ENCERRAMENTO
+} TipoRequisicao;
+
+/// @brief Resposta de uma requisição síncrona, mantida na pilha de quem a fez até que a partição a sinalize.
+typedef struct {
+    int pronta;
+    int resultado;
+    int registro;
+    pthread_mutex_t mutex;
+    pthread_cond_t condPronta;
+} Resposta;
+
+typedef struct {
+    TipoRequisicao tipo;
+    int chave;
+    int registro;
+    int esperado; // apenas COMPARACAO_TROCA
+    int chaveMax; // apenas PERCURSO e REMOCAO_INTERVALO
+    VisitaChave visita; // apenas PERCURSO
+    void* contexto; // apenas PERCURSO
+    FILE* saida; // apenas IMPRESSAO
+    Resposta* resposta; // NULL para requisições assíncronas
+} Requisicao;
+
+typedef struct {
+    ArvB* arv; // acessada apenas pela thread da partição
+
+    // fila circular limitada de requisições
+    Requisicao* requisicoes;
+    int inicio;
+    int tam;
+    int capacidade;
+    pthread_mutex_t mutex;
+    pthread_cond_t condNaoCheia;
+    pthread_cond_t condNaoVazia;
+
+    pthread_t thread;
+} Particao;
+
+struct _arvBParticionada {
+    int numParticoes;
+    int chaveMaxima;
+    Particao* particoes;
+};
+
+// --- FUNÇÕES INTERNAS
+static int idxParticao(ArvBParticionada* arv, int chave);
+static void enfileiraRequisicao(Particao* p, Requisicao* req);
+static void retiraRequisicao(Particao* p, Requisicao* req);
+static void executaSincrona(Particao* p, Requisicao* req);
+static void* atendeParticao(void* arg);
+// ---
+
+ArvBParticionada* criaArvBParticionada(ArvB** arvores, int numParticoes, int chaveMaxima, int capacidadeFila) {
+    if(arvores == NULL || numParticoes <= 0 || chaveMaxima < 0 || capacidadeFila <= 0) return NULL;
+
+    ArvBParticionada* arv = malloc(sizeof(ArvBParticionada));
+    arv->numParticoes = numParticoes;
+    arv->chaveMaxima = chaveMaxima;
+    arv->particoes = malloc(numParticoes * sizeof(Particao));
+
+    for(int i = 0; i < numParticoes; i++) {
+        Particao* p = &arv->particoes[i];
+        p->arv = arvores[i];
+        p->requisicoes = malloc(capacidadeFila * sizeof(Requisicao));
+        p->inicio = p->tam = 0;
+        p->capacidade = capacidadeFila;
+        pthread_mutex_init(&p->mutex, NULL);
+        pthread_cond_init(&p->condNaoCheia, NULL);
+        pthread_cond_init(&p->condNaoVazia, NULL);
+        pthread_create(&p->thread, NULL, atendeParticao, p);
+    }
+
+    return arv;
+}
+
+void insereParticionada(ArvBParticionada* arv, int chave, int registro) {
+    if(arv == NULL || chave < 0) return;
+
+    Requisicao req = {.tipo = INSERCAO, .chave = chave, .registro = registro};
+    enfileiraRequisicao(&arv->particoes[idxParticao(arv, chave)], &req);
+}
+
+void removeParticionada(ArvBParticionada* arv, int chave) {
+    if(arv == NULL || chave < 0) return;
+
+    Requisicao req = {.tipo = REMOCAO, .chave = chave};
+    enfileiraRequisicao(&arv->particoes[idxParticao(arv, chave)], &req);
+}
+
+int buscaParticionada(ArvBParticionada* arv, int chave, int* registroBuscado) {
+    if(arv == NULL || chave < 0) return 0;
+
+    Resposta resposta;
+    Requisicao req = {.tipo = BUSCA, .chave = chave, .resposta = &resposta};
+    executaSincrona(&arv->particoes[idxParticao(arv, chave)], &req);
+
+    if(resposta.resultado && registroBuscado != NULL) *registroBuscado = resposta.registro;
+    return resposta.resultado;
+}
+
+int insereSeAusenteParticionada(ArvBParticionada* arv, int chave, int registro, int* registroExistente) {
+    if(arv == NULL || chave < 0) return 0;
+
+    Resposta resposta;
+    Requisicao req = {.tipo = INSERCAO_SE_AUSENTE, .chave = chave, .registro = registro, .resposta = &resposta};
+    executaSincrona(&arv->particoes[idxParticao(arv, chave)], &req);
+
+    if(!resposta.resultado && registroExistente != NULL) *registroExistente = resposta.registro;
+    return resposta.resultado;
+}
+
+int comparaETrocaParticionada(ArvBParticionada* arv, int chave, int esperado, int novo, int* registroAtual) {
+    if(arv == NULL || chave < 0) return -1;
+
+    Resposta resposta;
+    Requisicao req = {.tipo = COMPARACAO_TROCA, .chave = chave, .registro = novo, .esperado = esperado,
+                      .resposta = &resposta};
+    executaSincrona(&arv->particoes[idxParticao(arv, chave)], &req);
+
+    if(resposta.resultado >= 0 && registroAtual != NULL) *registroAtual = resposta.registro;
+    return resposta.resultado;
+}
+
+int acumulaRegistroParticionada(ArvBParticionada* arv, int chave, int incremento) {
+    if(arv == NULL || chave < 0) return 0;
+
+    Resposta resposta;
+    Requisicao req = {.tipo = ACUMULO, .chave = chave, .registro = incremento, .resposta = &resposta};
+    executaSincrona(&arv->particoes[idxParticao(arv, chave)], &req);
+
+    return resposta.registro;
+}
+
+int removeERetornaParticionada(ArvBParticionada* arv, int chave, int* registroRemovido) {
+    if(arv == NULL || chave < 0) return 0;
+
+    Resposta resposta;
+    Requisicao req = {.tipo = REMOCAO_RETORNO, .chave = chave, .resposta = &resposta};
+    executaSincrona(&arv->particoes[idxParticao(arv, chave)], &req);
+
+    if(resposta.resultado && registroRemovido != NULL) *registroRemovido = resposta.registro;
+    return resposta.resultado;
+}
+
+void removeIntervaloParticionada(ArvBParticionada* arv, int chaveMin, int chaveMax) {
+    if(arv == NULL || chaveMax < 0 || chaveMin > chaveMax) return;
+    if(chaveMin < 0) chaveMin = 0;
+
+    // cada partição que intersecta o intervalo corta a sua parte de forma independente
+    for(int i = idxParticao(arv, chaveMin); i <= idxParticao(arv, chaveMax); i++) {
+        Requisicao req = {.tipo = REMOCAO_INTERVALO, .chave = chaveMin, .chaveMax = chaveMax};
+        enfileiraRequisicao(&arv->particoes[i], &req);
+    }
+}
+
+void percorreIntervaloParticionada(ArvBParticionada* arv, int chaveMin, int chaveMax, VisitaChave visita, void* contexto) {
+    if(arv == NULL || visita == NULL || chaveMax < 0 || chaveMin > chaveMax) return;
+    if(chaveMin < 0) chaveMin = 0;
+
+    // as partições cobrem intervalos disjuntos e crescentes, então percorrê-las em ordem já produz as chaves ordenadas
+    for(int i = idxParticao(arv, chaveMin); i <= idxParticao(arv, chaveMax); i++) {
+        Resposta resposta;
+        Requisicao req = {.tipo = PERCURSO, .chave = chaveMin, .chaveMax = chaveMax, .visita = visita,
+                          .contexto = contexto, .resposta = &resposta};
+        executaSincrona(&arv->particoes[i], &req);
+    }
+}
+
+void imprimeArvBParticionada(ArvBParticionada* arv, FILE* saida) {
+    if(arv == NULL) return;
+
+    for(int i = 0; i < arv->numParticoes; i++) {
+        Resposta resposta;
+        Requisicao req = {.tipo = IMPRESSAO, .saida = saida, .resposta = &resposta};
+        executaSincrona(&arv->particoes[i], &req);
+    }
+}
+
+void liberaArvBParticionada(ArvBParticionada* arv) {
+    if(arv == NULL) return;
+
+    // o encerramento entra no fim de cada fila, então as requisições pendentes ainda são aplicadas
+    for(int i = 0; i < arv->numParticoes; i++) {
+        Requisicao req = {.tipo = ENCERRAMENTO};
+        enfileiraRequisicao(&arv->particoes[i], &req);
+    }
+
+    for(int i = 0; i < arv->numParticoes; i++) {
+        Particao* p = &arv->particoes[i];
+        pthread_join(p->thread, NULL);
+        liberaArvB(p->arv);
+        free(p->requisicoes);
+        pthread_mutex_destroy(&p->mutex);
+        pthread_cond_destroy(&p->condNaoCheia);
+        pthread_cond_destroy(&p->condNaoVazia);
+    }
+
+    free(arv->particoes);
+    free(arv);
+}
+
+// Retorna a partição responsável pela chave: [0, chaveMaxima] é dividido em intervalos de mesmo tamanho
+static int idxParticao(ArvBParticionada* arv, int chave) {
+    if(chave >= arv->chaveMaxima) return arv->numParticoes - 1;
+    return (int)((long long)chave * arv->numParticoes / ((long long)arv->chaveMaxima + 1));
+}
+
+// Insere a requisição no fim da fila da partição, bloqueando enquanto a fila estiver cheia
+static void enfileiraRequisicao(Particao* p, Requisicao* req) {
+    pthread_mutex_lock(&p->mutex);
+    while(p->tam == p->capacidade) pthread_cond_wait(&p->condNaoCheia, &p->mutex);
+
+    p->requisicoes[(p->inicio + p->tam) % p->capacidade] = *req;
+    p->tam++;
+
+    pthread_cond_signal(&p->condNaoVazia);
+    pthread_mutex_unlock(&p->mutex);
+}
+
+// Remove a requisição do início da fila da partição, bloqueando enquanto a fila estiver vazia
+static void retiraRequisicao(Particao* p, Requisicao* req) {
+    pthread_mutex_lock(&p->mutex);
+    while(p->tam == 0) pthread_cond_wait(&p->condNaoVazia, &p->mutex);
+
+    *req = p->requisicoes[p->inicio];
+    p->inicio = (p->inicio + 1) % p->capacidade;
+    p->tam--;
+
+    pthread_cond_signal(&p->condNaoCheia);
+    pthread_mutex_unlock(&p->mutex);
+}
+
+// Encaminha a requisição à partição e espera a sua resposta
+static void executaSincrona(Particao* p, Requisicao* req) {
+    Resposta* resposta = req->resposta;
+    resposta->pronta = FALSE;
+    resposta->resultado = 0;
+    pthread_mutex_init(&resposta->mutex, NULL);
+    pthread_cond_init(&resposta->condPronta, NULL);
+
+    enfileiraRequisicao(p, req);
+
+    pthread_mutex_lock(&resposta->mutex);
+    while(!resposta->pronta) pthread_cond_wait(&resposta->condPronta, &resposta->mutex);
+    pthread_mutex_unlock(&resposta->mutex);
+
+    pthread_mutex_destroy(&resposta->mutex);
+    pthread_cond_destroy(&resposta->condPronta);
+}
+
+// Laço da thread de cada partição: aplica as requisições à sua árvore, em ordem de chegada, até o encerramento
+static void* atendeParticao(void* arg) {
+    Particao* p = arg;
+    Requisicao req;
+
+    do {
+        retiraRequisicao(p, &req);
+
+        int resultado = 0, registro = 0;
+        switch(req.tipo) {
+        case INSERCAO:
+            insereChaveValor(p->arv, req.chave, req.registro);
+            break;
+        case REMOCAO:
+            removeChaveValor(p->arv, req.chave);
+            break;
+        case BUSCA:
+            resultado = buscaChave(p->arv, req.chave, &registro);
+            break;
+        case INSERCAO_SE_AUSENTE:
+            resultado = insereSeAusente(p->arv, req.chave, req.registro, &registro);
+            break;
+        case COMPARACAO_TROCA:
+            resultado = comparaETroca(p->arv, req.chave, req.esperado, req.registro, &registro);
+            break;
+        case ACUMULO:
+            registro = acumulaRegistro(p->arv, req.chave, req.registro);
+            break;
+        case REMOCAO_RETORNO:
+            resultado = removeERetorna(p->arv, req.chave, &registro);
+            break;
+        case REMOCAO_INTERVALO:
+            removeIntervalo(p->arv, req.chave, req.chaveMax);
+            break;
+        case PERCURSO:
+            percorreIntervalo(p->arv, req.chave, req.chaveMax, req.visita, req.contexto);
+            break;
+        case IMPRESSAO:
+            imprimeArvB(p->arv, req.saida);
+            break;
+        default:
+            break;
+        }
+
+        if(req.resposta != NULL) {
+            pthread_mutex_lock(&req.resposta->mutex);
+            req.resposta->resultado = resultado;
+            req.resposta->registro = registro;
+            req.resposta->pronta = TRUE;
+            pthread_cond_signal(&req.resposta->condPronta);
+            pthread_mutex_unlock(&req.resposta->mutex);
+        }
+    } while(req.tipo != ENCERRAMENTO);
+
+    return NULL;
+}
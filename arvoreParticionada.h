@@ -0,0 +1,104 @@
+/**
+ * @file    arvoreParticionada.h
+ * @brief   Arquivo responsável pela definição da interface com o cliente da árvore B particionada por intervalos de chave.
+ * @author  Daniel Corona de Aguiar (daniel.aguiar@edu.ufes.br/2023101578)
+ * @author  João Pedro Pereira Loss (joao.loss@edu.ufes.br/2023102068)
+ * @author  Raphael Correia Dornelas (raphael.dornelas@edu.ufes.br/2023100595)
+ */
+
+#ifndef ARVB_PARTICIONADA_H
+#define ARVB_PARTICIONADA_H
+
+#include "arvoreB.h"
+
+/// @brief TAD opaco responsável por dividir o espaço de chaves [0, chaveMaxima] em partições de mesmo tamanho, cada uma
+/// armazenada em uma árvore B independente e atendida por uma thread dedicada com uma fila limitada de requisições. Como
+/// cada partição é atendida por uma única thread, em ordem de chegada, as operações sobre uma mesma chave são aplicadas na
+/// ordem em que foram feitas.
+typedef struct _arvBParticionada ArvBParticionada;
+
+/// @brief Cria a estrutura particionada a partir de árvores vazias já criadas pelo cliente (cada uma com seu próprio
+/// arquivo binário ou em memória), que passam a pertencer à estrutura e são liberadas junto com ela.
+/// @param arvores Vetor com uma árvore por partição, em ordem crescente de intervalo de chaves
+/// @param numParticoes Número de partições
+/// @param chaveMaxima Maior chave esperada; chaves acima dela vão para a última partição
+/// @param capacidadeFila Número máximo de requisições pendentes em cada partição
+/// @return Ponteiro para a estrutura alocada dinamicamente ou NULL se os parâmetros forem inválidos.
+ArvBParticionada* criaArvBParticionada(ArvB** arvores, int numParticoes, int chaveMaxima, int capacidadeFila);
+
+/// @brief Encaminha a inserção de um par chave/registro à partição da chave, sem esperar que ela seja aplicada.
+/// @param arv Ponteiro para a árvore particionada
+/// @param chave Chave a ser inserida
+/// @param registro Registro correspondente à chave
+void insereParticionada(ArvBParticionada* arv, int chave, int registro);
+
+/// @brief Encaminha a remoção de uma chave à partição da chave, sem esperar que ela seja aplicada.
+/// @param arv Ponteiro para a árvore particionada
+/// @param chave Chave a ser removida
+void removeParticionada(ArvBParticionada* arv, int chave);
+
+/// @brief Busca uma chave na sua partição, esperando que as operações encaminhadas antes a essa partição sejam aplicadas.
+/// @param arv Ponteiro para a árvore particionada
+/// @param chave Chave a ser buscada
+/// @param registroBuscado Ponteiro para o local onde o registro buscado deve ser armazenado (pode ser NULL)
+/// @return 1 se a chave for encontrada e 0, caso contrário.
+int buscaParticionada(ArvBParticionada* arv, int chave, int* registroBuscado);
+
+/// @brief Versão particionada de insereSeAusente, aplicada pela thread da partição da chave após as operações encaminhadas
+/// antes a ela.
+/// @param arv Ponteiro para a árvore particionada
+/// @param chave Chave a ser inserida
+/// @param registro Registro correspondente à chave
+/// @param registroExistente Ponteiro para o local onde o registro já presente deve ser armazenado (pode ser NULL)
+/// @return 1 se a chave foi inserida e 0 se ela já estava na árvore.
+int insereSeAusenteParticionada(ArvBParticionada* arv, int chave, int registro, int* registroExistente);
+
+/// @brief Versão particionada de comparaETroca.
+/// @param arv Ponteiro para a árvore particionada
+/// @param chave Chave cujo registro deve ser comparado
+/// @param esperado Registro esperado
+/// @param novo Registro que substitui o esperado
+/// @param registroAtual Ponteiro para o local onde o registro encontrado, antes da troca, deve ser armazenado (pode ser NULL)
+/// @return 1 se o registro foi trocado, 0 se ele era diferente do esperado e -1 se a chave não está na árvore.
+int comparaETrocaParticionada(ArvBParticionada* arv, int chave, int esperado, int novo, int* registroAtual);
+
+/// @brief Versão particionada de acumulaRegistro.
+/// @param arv Ponteiro para a árvore particionada
+/// @param chave Chave cujo registro deve ser acumulado
+/// @param incremento Valor somado ao registro
+/// @return O registro da chave após a soma.
+int acumulaRegistroParticionada(ArvBParticionada* arv, int chave, int incremento);
+
+/// @brief Versão particionada de removeERetorna.
+/// @param arv Ponteiro para a árvore particionada
+/// @param chave Chave a ser removida
+/// @param registroRemovido Ponteiro para o local onde o registro removido deve ser armazenado (pode ser NULL)
+/// @return 1 se a chave foi removida e 0 se ela não estava na árvore.
+int removeERetornaParticionada(ArvBParticionada* arv, int chave, int* registroRemovido);
+
+/// @brief Encaminha a remoção das chaves em [chaveMin, chaveMax] a todas as partições que intersectam o intervalo, sem
+/// esperar que ela seja aplicada.
+/// @param arv Ponteiro para a árvore particionada
+/// @param chaveMin Menor chave do intervalo
+/// @param chaveMax Maior chave do intervalo
+void removeIntervaloParticionada(ArvBParticionada* arv, int chaveMin, int chaveMax);
+
+/// @brief Percorre, em ordem crescente de chave, os pares com chave em [chaveMin, chaveMax] de todas as partições que
+/// intersectam o intervalo. 'visita' é chamada pela thread de cada partição, uma partição por vez.
+/// @param arv Ponteiro para a árvore particionada
+/// @param chaveMin Menor chave do intervalo
+/// @param chaveMax Maior chave do intervalo
+/// @param visita Função chamada para cada par visitado
+/// @param contexto Ponteiro repassado a cada chamada de 'visita'
+void percorreIntervaloParticionada(ArvBParticionada* arv, int chaveMin, int chaveMax, VisitaChave visita, void* contexto);
+
+/// @brief Imprime, em ordem de partição, cada árvore por níveis de profundidade.
+/// @param arv Ponteiro para a árvore particionada
+/// @param saida Referência para o local onde a impressão deve ser realizada
+void imprimeArvBParticionada(ArvBParticionada* arv, FILE* saida);
+
+/// @brief Espera que todas as requisições pendentes sejam aplicadas, encerra as threads e libera todas as árvores.
+/// @param arv Ponteiro para a árvore particionada
+void liberaArvBParticionada(ArvBParticionada* arv);
+
+#endif
@@ -0,0 +1,122 @@
+/**
+ * @file    desempenho.c
+ * @brief   Arquivo responsável pela implementação das cargas de medição de desempenho da árvore B.
+ * @author  Daniel Corona de Aguiar (daniel.aguiar@edu.ufes.br/2023101578)
+ * @author  João Pedro Pereira Loss (joao.loss@edu.ufes.br/2023102068)
+ * @author  Raphael Correia Dornelas (raphael.dornelas@edu.ufes.br/2023100595)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "arvoreB.h"
+#include "desempenho.h"
+
+#define SEMENTE_CARGA 2023u
+
+// --- FUNÇÕES DE INTERFACE
+int calibraOrdem(const int* tamPaginas, int numTamanhos, int numOperacoes, double fracaoEscrita, const char* nomeArqBin, FILE* relatorio,
+                 int* tamPaginaRecomendado);
+double comparaModosArmazenamento(int ordem, int numOperacoes, double fracaoEscrita, const char* nomeArqBin, FILE* relatorio);
+// ---
+
+// --- FUNÇÕES INTERNAS
+static unsigned int proximoAleatorio(unsigned int* estado);
+static double tempoAtual();
+static double executaCarga(ArvB* arv, int numOperacoes, double fracaoEscrita);
+// ---
+
+// --- IMPLEMENTAÇÕES
+int calibraOrdem(const int* tamPaginas, int numTamanhos, int numOperacoes, double fracaoEscrita, const char* nomeArqBin, FILE* relatorio,
+                 int* tamPaginaRecomendado) {
+    if(tamPaginas == NULL || numTamanhos <= 0 || numOperacoes <= 0) return -1;
+
+    int melhorOrdem = -1;
+    double melhorVazao = 0;
+    for(int i = 0; i < numTamanhos; i++) {
+        ArvB* arv = criaArvBPagina(tamPaginas[i]);
+        if(arv == NULL) {
+            if(relatorio) fprintf(relatorio, "pagina %d: tamanho insuficiente\n", tamPaginas[i]);
+            continue;
+        }
+        defineArqBinArvB(arv, nomeArqBin);
+
+        double segundos = executaCarga(arv, numOperacoes, fracaoEscrita);
+        double vazao = segundos > 0 ? numOperacoes / segundos : 0;
+        if(relatorio) {
+            fprintf(relatorio, "pagina %d: ordem %d, %.0f ops/s\n", tamPaginas[i], getOrdemArvB(arv), vazao);
+        }
+
+        if(melhorOrdem == -1 || vazao > melhorVazao) {
+            melhorOrdem = getOrdemArvB(arv);
+            melhorVazao = vazao;
+            if(tamPaginaRecomendado) *tamPaginaRecomendado = tamPaginas[i];
+        }
+        liberaArvB(arv);
+    }
+
+    return melhorOrdem;
+}
+
+double comparaModosArmazenamento(int ordem, int numOperacoes, double fracaoEscrita, const char* nomeArqBin, FILE* relatorio) {
+    if(ordem < 3 || numOperacoes <= 0) return -1;
+
+    ArvB* arvArquivo = criaArvB(ordem);
+    defineArqBinArvB(arvArquivo, nomeArqBin);
+    double vazaoArquivo = numOperacoes / executaCarga(arvArquivo, numOperacoes, fracaoEscrita);
+    liberaArvB(arvArquivo);
+
+    ArvB* arvMemoria = criaArvBMemoria(ordem);
+    double vazaoMemoria = numOperacoes / executaCarga(arvMemoria, numOperacoes, fracaoEscrita);
+    liberaArvB(arvMemoria);
+
+    if(relatorio) {
+        fprintf(relatorio, "arquivo: ordem %d, %.0f ops/s\n", ordem, vazaoArquivo);
+        fprintf(relatorio, "memoria: ordem %d, %.0f ops/s\n", ordem, vazaoMemoria);
+    }
+
+    return vazaoMemoria / vazaoArquivo;
+}
+
+// Gerador congruencial linear: a carga precisa ser a mesma para todos os candidatos, independente de rand()
+static unsigned int proximoAleatorio(unsigned int* estado) {
+    *estado = *estado * 1103515245u + 12345u;
+    return (*estado >> 1) & 0x7fffffff;
+}
+
+// Retorna o tempo de relógio em segundos (o tempo de CPU não contabilizaria a espera pelo disco)
+static double tempoAtual() {
+    struct timespec t;
+    timespec_get(&t, TIME_UTC);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// Executa a carga de inserções/buscas aleatórias na árvore e retorna o tempo gasto em segundos. Antes da medição, a árvore
+// é povoada com chaves aleatórias (tantas inserções quanto metade do espaço de chaves) para que as operações medidas
+// percorram uma árvore com a altura de uso real. Na árvore em arquivo, a medição usa o acesso direto: sem ele, o arquivo
+// inteiro caberia no cache do sistema e a carga mediria a memória, e não o disco.
+static double executaCarga(ArvB* arv, int numOperacoes, double fracaoEscrita) {
+    unsigned int estado = SEMENTE_CARGA;
+    int limiteEscrita = (int)(fracaoEscrita * 1000);
+    int espacoChaves = numOperacoes * 4;
+    int registro = 0;
+
+    for(int i = 0; i < espacoChaves / 2; i++) {
+        insereChaveValor(arv, proximoAleatorio(&estado) % espacoChaves, i);
+    }
+    defineAcessoDiretoArvB(arv, 1);
+
+    double inicio = tempoAtual();
+    for(int i = 0; i < numOperacoes; i++) {
+        int chave = proximoAleatorio(&estado) % espacoChaves;
+        if((int)(proximoAleatorio(&estado) % 1000) < limiteEscrita) {
+            insereChaveValor(arv, chave, i);
+        } else {
+            buscaChave(arv, chave, &registro);
+        }
+    }
+
+    return tempoAtual() - inicio;
+}
+// ---
@@ -0,0 +1,38 @@
+/**
+ * @file    desempenho.h
+ * @brief   Arquivo responsável pela definição da interface de medição de desempenho da árvore B.
+ * @author  Daniel Corona de Aguiar (daniel.aguiar@edu.ufes.br/2023101578)
+ * @author  João Pedro Pereira Loss (joao.loss@edu.ufes.br/2023102068)
+ * @author  Raphael Correia Dornelas (raphael.dornelas@edu.ufes.br/2023100595)
+ */
+
+#ifndef DESEMPENHO_H
+#define DESEMPENHO_H
+
+/// @brief Executa uma carga curta de calibração (inserções e buscas de chaves aleatórias) em árvores criadas a partir de
+/// cada tamanho de página candidato, no próprio disco onde o arquivo binário é criado, e recomenda a ordem com maior vazão.
+/// Cada página lida ou gravada durante a medição chega ao dispositivo (ver defineAcessoDiretoArvB).
+/// @param tamPaginas Vetor com os tamanhos de página candidatos, em bytes
+/// @param numTamanhos Quantidade de tamanhos candidatos
+/// @param numOperacoes Número de operações da carga executada para cada candidato
+/// @param fracaoEscrita Fração das operações que são inserções (entre 0 e 1); as demais são buscas
+/// @param nomeArqBin Caminho do arquivo binário temporário utilizado durante a calibração
+/// @param relatorio Local onde a vazão de cada candidato deve ser impressa (pode ser NULL)
+/// @param tamPaginaRecomendado Ponteiro para o local onde o tamanho de página recomendado deve ser armazenado, a ser usado
+/// na opção -p do programa principal (pode ser NULL)
+/// @return A ordem recomendada ou -1 se nenhum candidato for válido.
+int calibraOrdem(const int* tamPaginas, int numTamanhos, int numOperacoes, double fracaoEscrita, const char* nomeArqBin, FILE* relatorio,
+                 int* tamPaginaRecomendado);
+
+/// @brief Executa a mesma carga de inserções e buscas aleatórias em uma árvore mantida em arquivo e em uma árvore mantida
+/// em memória (arena), ambas com a ordem fornecida, e compara suas vazões. Na árvore em arquivo, cada página lida ou
+/// gravada durante a medição chega ao dispositivo (ver defineAcessoDiretoArvB).
+/// @param ordem Ordem das árvores
+/// @param numOperacoes Número de operações da carga
+/// @param fracaoEscrita Fração das operações que são inserções (entre 0 e 1); as demais são buscas
+/// @param nomeArqBin Caminho do arquivo binário temporário utilizado pela árvore mantida em arquivo
+/// @param relatorio Local onde a vazão de cada modo deve ser impressa (pode ser NULL)
+/// @return Razão entre a vazão da árvore em memória e a da árvore em arquivo ou -1 se a ordem for inválida.
+double comparaModosArmazenamento(int ordem, int numOperacoes, double fracaoEscrita, const char* nomeArqBin, FILE* relatorio);
+
+#endif
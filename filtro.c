@@ -0,0 +1,142 @@
+/**
+ * @file    filtro.c
+ * @brief   Arquivo responsável pela implementação do filtro de Bloom com contadores e de suas funções de criação,
+ * manipulação, persistência e liberação.
+ * @author  Daniel Corona de Aguiar (daniel.aguiar@edu.ufes.br/2023101578)
+ * @author  João Pedro Pereira Loss (joao.loss@edu.ufes.br/2023102068)
+ * @author  Raphael Correia Dornelas (raphael.dornelas@edu.ufes.br/2023100595)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "filtro.h"
+
+#define CONTADOR_SATURADO 255
+
+struct _filtro {
+    int numContadores;
+    int numHashes;
+    unsigned char* contadores;
+    // um contador saturado nunca é decrementado, pois não se sabe quantas chaves ele de fato conta
+};
+
+// --- FUNÇÕES INTERNAS
+static unsigned int misturaBits(unsigned int x);
+static void hashesChave(int chave, unsigned int* h1, unsigned int* h2);
+static int posicaoHash(Filtro* f, unsigned int h1, unsigned int h2, int i);
+// ---
+
+Filtro* criaFiltro(int numChavesEsperadas, double taxaFalsoPositivo) {
+    if(numChavesEsperadas <= 0 || taxaFalsoPositivo <= 0 || taxaFalsoPositivo >= 1) return NULL;
+
+    // dimensionamento ótimo: m = -n ln(p) / ln(2)^2 contadores e k = (m/n) ln(2) funções de hash
+    double m = ceil(-numChavesEsperadas * log(taxaFalsoPositivo) / (log(2) * log(2)));
+    int k = (int)round(m / numChavesEsperadas * log(2));
+
+    Filtro* f = malloc(sizeof(Filtro));
+    f->numContadores = (int)m;
+    f->numHashes = k < 1 ? 1 : k;
+    f->contadores = calloc(f->numContadores, sizeof(unsigned char));
+
+    return f;
+}
+
+void insereFiltro(Filtro* f, int chave) {
+    if(f == NULL) return;
+
+    unsigned int h1, h2;
+    hashesChave(chave, &h1, &h2);
+    for(int i = 0; i < f->numHashes; i++) {
+        unsigned char* c = &f->contadores[posicaoHash(f, h1, h2, i)];
+        if(*c < CONTADOR_SATURADO) (*c)++;
+    }
+}
+
+void removeFiltro(Filtro* f, int chave) {
+    if(f == NULL) return;
+
+    unsigned int h1, h2;
+    hashesChave(chave, &h1, &h2);
+    for(int i = 0; i < f->numHashes; i++) {
+        unsigned char* c = &f->contadores[posicaoHash(f, h1, h2, i)];
+        if(*c > 0 && *c < CONTADOR_SATURADO) (*c)--;
+    }
+}
+
+int consultaFiltro(Filtro* f, int chave) {
+    if(f == NULL) return 1;
+
+    unsigned int h1, h2;
+    hashesChave(chave, &h1, &h2);
+    for(int i = 0; i < f->numHashes; i++) {
+        if(f->contadores[posicaoHash(f, h1, h2, i)] == 0) return 0;
+    }
+    return 1;
+}
+
+int salvaFiltro(Filtro* f, const char* nomeArq) {
+    if(f == NULL || nomeArq == NULL) return 0;
+
+    FILE* arq = fopen(nomeArq, "wb");
+    if(arq == NULL) return 0;
+
+    int gravado = fwrite(&f->numContadores, sizeof(int), 1, arq) == 1 && fwrite(&f->numHashes, sizeof(int), 1, arq) == 1 &&
+                  fwrite(f->contadores, sizeof(unsigned char), f->numContadores, arq) == (size_t)f->numContadores;
+    if(fclose(arq) != 0) gravado = 0;
+    return gravado;
+}
+
+Filtro* carregaFiltro(const char* nomeArq) {
+    FILE* arq = nomeArq ? fopen(nomeArq, "rb") : NULL;
+    if(arq == NULL) return NULL;
+
+    int numContadores = 0, numHashes = 0;
+    if(fread(&numContadores, sizeof(int), 1, arq) != 1 || fread(&numHashes, sizeof(int), 1, arq) != 1
+       || numContadores <= 0 || numHashes <= 0) {
+        fclose(arq);
+        return NULL;
+    }
+
+    Filtro* f = malloc(sizeof(Filtro));
+    f->numContadores = numContadores;
+    f->numHashes = numHashes;
+    f->contadores = calloc(numContadores, sizeof(unsigned char));
+    int lido = fread(f->contadores, sizeof(unsigned char), numContadores, arq) == (size_t)numContadores;
+
+    fclose(arq);
+    if(!lido) {
+        liberaFiltro(f);
+        return NULL;
+    }
+    return f;
+}
+
+void liberaFiltro(Filtro* f) {
+    if(f == NULL) return;
+
+    free(f->contadores);
+    free(f);
+}
+
+// Finalizador do MurmurHash3: espalha os bits da chave para que chaves próximas caiam em contadores distantes
+static unsigned int misturaBits(unsigned int x) {
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x;
+}
+
+// Calcula os dois hashes base da chave, a partir dos quais são derivadas todas as funções de hash do filtro
+static void hashesChave(int chave, unsigned int* h1, unsigned int* h2) {
+    *h1 = misturaBits((unsigned int)chave);
+    *h2 = misturaBits(*h1 ^ 0x9e3779b9u) | 1u;
+}
+
+// Retorna a posição do contador da i-ésima função de hash (hash duplo: h1 + i*h2)
+static int posicaoHash(Filtro* f, unsigned int h1, unsigned int h2, int i) {
+    return (int)((h1 + (unsigned int)i*h2) % (unsigned int)f->numContadores);
+}
@@ -0,0 +1,53 @@
+/**
+ * @file    filtro.h
+ * @brief   Arquivo responsável pela definição da interface com o cliente do filtro de pertinência de chaves.
+ * @author  Daniel Corona de Aguiar (daniel.aguiar@edu.ufes.br/2023101578)
+ * @author  João Pedro Pereira Loss (joao.loss@edu.ufes.br/2023102068)
+ * @author  Raphael Correia Dornelas (raphael.dornelas@edu.ufes.br/2023100595)
+ */
+
+#ifndef FILTRO_H
+#define FILTRO_H
+
+/// @brief TAD opaco responsável por um filtro de Bloom com contadores, que responde se uma chave certamente não pertence
+/// ao conjunto ou se possivelmente pertence a ele. Como cada posição é um contador, chaves também podem ser retiradas.
+typedef struct _filtro Filtro;
+
+/// @brief Cria um filtro vazio dimensionado para o número de chaves e a taxa de falsos positivos desejados.
+/// @param numChavesEsperadas Número de chaves que se espera armazenar
+/// @param taxaFalsoPositivo Taxa de falsos positivos desejada (entre 0 e 1, exclusive)
+/// @return Ponteiro para o filtro alocado dinamicamente ou NULL se os parâmetros forem inválidos.
+Filtro* criaFiltro(int numChavesEsperadas, double taxaFalsoPositivo);
+
+/// @brief Acrescenta uma chave ao filtro. Cada chave deve ser acrescentada uma única vez enquanto estiver no conjunto.
+/// @param f Ponteiro para o filtro
+/// @param chave Chave a ser acrescentada
+void insereFiltro(Filtro* f, int chave);
+
+/// @brief Retira do filtro uma chave acrescentada anteriormente.
+/// @param f Ponteiro para o filtro
+/// @param chave Chave a ser retirada
+void removeFiltro(Filtro* f, int chave);
+
+/// @brief Consulta se uma chave pode pertencer ao conjunto.
+/// @param f Ponteiro para o filtro
+/// @param chave Chave a ser consultada
+/// @return 0 se a chave certamente não pertence ao conjunto e 1 se ela possivelmente pertence.
+int consultaFiltro(Filtro* f, int chave);
+
+/// @brief Salva o filtro no arquivo fornecido.
+/// @param f Ponteiro para o filtro
+/// @param nomeArq Caminho do arquivo
+/// @return 1 se o filtro foi salvo e 0, caso contrário.
+int salvaFiltro(Filtro* f, const char* nomeArq);
+
+/// @brief Recria um filtro salvo com salvaFiltro.
+/// @param nomeArq Caminho do arquivo
+/// @return Ponteiro para o filtro alocado dinamicamente ou NULL se o arquivo não puder ser lido.
+Filtro* carregaFiltro(const char* nomeArq);
+
+/// @brief Libera toda a memória utilizada pelo filtro.
+/// @param f Ponteiro para o filtro
+void liberaFiltro(Filtro* f);
+
+#endif
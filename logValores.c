@@ -0,0 +1,102 @@
+/**
+ * @file    logValores.c
+ * @brief   Arquivo responsável pela implementação do log de valores de tamanho variável e de suas funções de criação,
+ * acesso, manipulação e liberação.
+ * @author  Daniel Corona de Aguiar (daniel.aguiar@edu.ufes.br/2023101578)
+ * @author  João Pedro Pereira Loss (joao.loss@edu.ufes.br/2023102068)
+ * @author  Raphael Correia Dornelas (raphael.dornelas@edu.ufes.br/2023100595)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "logValores.h"
+
+// cabeçalho de cada entrada: chave e tamanho do valor
+#define TAM_CABECALHO_ENTRADA (int)(sizeof(int)*2)
+
+struct _logValores {
+    int tam; // tamanho do arquivo em bytes, ou seja, deslocamento da próxima entrada (no máximo INT_MAX)
+    char* nomeArq;
+    FILE* arq;
+};
+
+LogValores* criaLogValores(const char* nomeArq) {
+    FILE* arq = fopen(nomeArq, "wb+");
+    if(arq == NULL) return NULL;
+
+    LogValores* log = malloc(sizeof(LogValores));
+    log->tam = 0;
+    log->arq = arq;
+    log->nomeArq = malloc(strlen(nomeArq) + 1);
+    strcpy(log->nomeArq, nomeArq);
+
+    return log;
+}
+
+int anexaValorLog(LogValores* log, int chave, const void* valor, int tamValor) {
+    if(log == NULL || tamValor < 0) return -1;
+    // os deslocamentos são registros int da árvore: uma entrada que passaria de INT_MAX bytes é recusada
+    if(tamValor > INT_MAX - TAM_CABECALHO_ENTRADA - log->tam) return -1;
+
+    int offset = log->tam;
+    fseek(log->arq, offset, SEEK_SET);
+    if(fwrite(&chave, sizeof(int), 1, log->arq) != 1 || fwrite(&tamValor, sizeof(int), 1, log->arq) != 1 ||
+       fwrite(valor, 1, tamValor, log->arq) != (size_t)tamValor || fflush(log->arq) != 0) {
+        return -1; // a entrada incompleta fica além de 'tam' e é sobrescrita pelo próximo anexo
+    }
+
+    log->tam += TAM_CABECALHO_ENTRADA + tamValor;
+    return offset;
+}
+
+int leValorLog(LogValores* log, int offset, int* chave, void* valor, int tamMax) {
+    if(log == NULL || offset < 0 || offset > log->tam - TAM_CABECALHO_ENTRADA) return -1;
+
+    int chaveEntrada, tamValor;
+    fseek(log->arq, offset, SEEK_SET);
+    if(fread(&chaveEntrada, sizeof(int), 1, log->arq) != 1 || fread(&tamValor, sizeof(int), 1, log->arq) != 1 ||
+       tamValor < 0 || tamValor > log->tam - TAM_CABECALHO_ENTRADA - offset) {
+        return -1;
+    }
+
+    if(chave != NULL) *chave = chaveEntrada;
+    if(valor != NULL && tamMax > 0) {
+        fread(valor, 1, tamValor < tamMax ? tamValor : tamMax, log->arq);
+    }
+
+    return tamValor;
+}
+
+int proximaEntradaLog(LogValores* log, int offset) {
+    int tamValor = leValorLog(log, offset, NULL, NULL, 0);
+    if(tamValor == -1) return -1;
+
+    int proxima = offset + TAM_CABECALHO_ENTRADA + tamValor;
+    return proxima < log->tam ? proxima : -1;
+}
+
+int getTamLog(LogValores* log) {
+    if(log == NULL) return 0;
+    return log->tam;
+}
+
+int renomeiaLogValores(LogValores* log, const char* nomeArq) {
+    if(log == NULL || nomeArq == NULL || rename(log->nomeArq, nomeArq) != 0) return 0;
+
+    free(log->nomeArq);
+    log->nomeArq = malloc(strlen(nomeArq) + 1);
+    strcpy(log->nomeArq, nomeArq);
+    return 1;
+}
+
+void liberaLogValores(LogValores* log, int removeArq) {
+    if(log == NULL) return;
+
+    fclose(log->arq);
+    if(removeArq) remove(log->nomeArq);
+    free(log->nomeArq);
+    free(log);
+}
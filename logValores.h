@@ -0,0 +1,63 @@
+/**
+ * @file    logValores.h
+ * @brief   Arquivo responsável pela definição da interface com o cliente do log de valores de tamanho variável.
+ * @author  Daniel Corona de Aguiar (daniel.aguiar@edu.ufes.br/2023101578)
+ * @author  João Pedro Pereira Loss (joao.loss@edu.ufes.br/2023102068)
+ * @author  Raphael Correia Dornelas (raphael.dornelas@edu.ufes.br/2023100595)
+ */
+
+#ifndef LOG_VALORES_H
+#define LOG_VALORES_H
+
+/// @brief TAD opaco responsável por um arquivo binário de valores de tamanho variável onde novas entradas são sempre
+/// anexadas ao final. Cada entrada guarda a chave à qual o valor pertence, o tamanho do valor e os bytes do valor, e é
+/// identificada pelo seu deslocamento (em bytes) no arquivo.
+typedef struct _logValores LogValores;
+
+/// @brief Cria um log vazio, descartando o conteúdo do arquivo caso ele já exista.
+/// @param nomeArq Caminho do arquivo do log
+/// @return Ponteiro para o log alocado dinamicamente ou NULL se o arquivo não puder ser criado.
+LogValores* criaLogValores(const char* nomeArq);
+
+/// @brief Anexa uma entrada ao final do log. Os deslocamentos são int, então uma entrada que faria o log passar de
+/// INT_MAX bytes é recusada e o log não é alterado.
+/// @param log Ponteiro para o log
+/// @param chave Chave à qual o valor pertence
+/// @param valor Bytes do valor
+/// @param tamValor Tamanho do valor em bytes
+/// @return Deslocamento da entrada no log ou -1 se a entrada for recusada ou em caso de erro de escrita.
+int anexaValorLog(LogValores* log, int chave, const void* valor, int tamValor);
+
+/// @brief Lê a entrada que começa no deslocamento fornecido. Apenas os primeiros 'tamMax' bytes do valor são copiados.
+/// @param log Ponteiro para o log
+/// @param offset Deslocamento da entrada
+/// @param chave Ponteiro para o local onde a chave da entrada deve ser armazenada (pode ser NULL)
+/// @param valor Local onde o valor deve ser copiado (pode ser NULL)
+/// @param tamMax Capacidade, em bytes, de 'valor'
+/// @return Tamanho total do valor ou -1 se o deslocamento não corresponder a uma entrada.
+int leValorLog(LogValores* log, int offset, int* chave, void* valor, int tamMax);
+
+/// @brief Retorna o deslocamento da entrada seguinte à que começa em 'offset', permitindo percorrer o log sequencialmente
+/// a partir do deslocamento 0.
+/// @param log Ponteiro para o log
+/// @param offset Deslocamento de uma entrada
+/// @return Deslocamento da próxima entrada ou -1 se 'offset' for a última entrada ou não corresponder a uma entrada.
+int proximaEntradaLog(LogValores* log, int offset);
+
+/// @brief Retorna o tamanho do log em bytes.
+/// @param log Ponteiro para o log
+/// @return Tamanho do log em bytes.
+int getTamLog(LogValores* log);
+
+/// @brief Renomeia o arquivo do log, substituindo qualquer arquivo existente com o novo nome. O log continua aberto.
+/// @param log Ponteiro para o log
+/// @param nomeArq Novo caminho do arquivo do log
+/// @return 1 se o arquivo foi renomeado e 0, caso contrário.
+int renomeiaLogValores(LogValores* log, const char* nomeArq);
+
+/// @brief Fecha o log e libera a memória utilizada por ele.
+/// @param log Ponteiro para o log
+/// @param removeArq 1 se o arquivo do log também deve ser apagado e 0, caso contrário
+void liberaLogValores(LogValores* log, int removeArq);
+
+#endif
@@ -9,18 +9,437 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 #include "arvoreB.h"
+#include "arvoreParticionada.h"
+#include "anel.h"
 
 #define MSG_REGISTRO_ENCONTRADO "O REGISTRO ESTA NA ARVORE!\n"
 #define MSG_REGISTRO_NAO_ENCONTRADO "O REGISTRO NAO ESTA NA ARVORE!\n"
+#define MSG_REGISTRO_INSERIDO "O REGISTRO FOI INSERIDO!\n"
+#define MSG_REGISTRO_JA_PRESENTE "O REGISTRO JA ESTAVA NA ARVORE: %d\n"
+#define MSG_REGISTRO_TROCADO "O REGISTRO FOI TROCADO!\n"
+#define MSG_REGISTRO_NAO_TROCADO "O REGISTRO NAO FOI TROCADO: %d\n"
+#define MSG_REGISTRO_ACUMULADO "O REGISTRO ACUMULADO E %d\n"
+#define MSG_REGISTRO_REMOVIDO "O REGISTRO REMOVIDO ERA: %d\n"
+#define TAXA_FALSO_POSITIVO_FILTRO 0.01
+#define CAPACIDADE_FILA_PARTICAO 1024
+#define TAM_NOME_ARQ_PARTICAO 32
+#define TAM_BLOCO_COMANDOS 64
+#define CAPACIDADE_ANEL 64
+#define LIMITE_ESPERA_ATIVA 64 // tentativas (cedendo o processador) antes de bloquear em um anel cheio ou vazio
+
+typedef struct {
+    char operacao;
+    int chave;
+    int registro; // em 'S', o incremento
+    int esperado; // apenas 'C'
+    int chaveMax; // apenas 'D'
+} Comando;
+
+/// @brief Bloco de comandos que passa da leitura para a execução; um bloco com 'fim' marca o fim da entrada.
+typedef struct {
+    int fim;
+    int numComandos;
+    Comando comandos[TAM_BLOCO_COMANDOS];
+} BlocoComandos;
+
+/// @brief Resultado de um comando que gera saída (busca ou operação de leitura-modificação-escrita).
+typedef struct {
+    char operacao;
+    int sucesso;
+    int registro;
+} Resultado;
+
+/// @brief Resultados de um bloco de comandos, na ordem dos comandos, que passam da execução para a saída.
+typedef struct {
+    int fim;
+    int numResultados;
+    Resultado resultados[TAM_BLOCO_COMANDOS];
+} BlocoResultados;
+
+/// @brief Anel ligando duas etapas, com a espera de cada ponta: após uma espera ativa limitada, a etapa bloqueia na
+/// sua condição, que a outra ponta sinaliza ao inserir ou retirar um elemento. Os vetores são indexados pela ponta
+/// (0: consumidora, que espera o anel deixar de estar vazio; 1: produtora, que espera ele deixar de estar cheio).
+typedef struct {
+    Anel* anel;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond[2];
+    atomic_int bloqueada[2]; // 1: a ponta está (ou está prestes a ficar) bloqueada na sua condição
+} AnelEspera;
+
+/// @brief Contadores de uma etapa do pipeline. As esperas indicam onde ele trava: uma etapa que espera pela entrada é
+/// mais rápida que a anterior, e uma que espera pela saída é mais rápida que a seguinte.
+typedef struct {
+    long itens;
+    long esperasEntrada; // vezes em que o anel de entrada estava vazio
+    long esperasSaida; // vezes em que o anel de saída estava cheio
+    double tempoEspera;
+    double tempoTotal;
+} ContadoresEtapa;
+
+typedef struct {
+    FILE* arqEntrada;
+    FILE* arqSaida;
+    int numOperacoes;
+    ArvB* arvB;
+    ArvBParticionada* arvP;
+
+    AnelEspera comandos; // leitura -> execução
+    AnelEspera resultados; // execução -> saída
+
+    ContadoresEtapa leitura;
+    ContadoresEtapa execucao;
+    ContadoresEtapa saida;
+} Pipeline;
+
+// Cria uma árvore conforme as opções da linha de comando (retorna NULL se a página não comportar um nó)
+static ArvB* criaArvBOpcoes(int ordem, int tamPagina, int emMemoria, int chavesEsperadasFiltro, int capacidadeBuffer) {
+    // com -p a ordem é derivada do tamanho de página e a ordem do arquivo de entrada é ignorada
+    // com -m os nós ficam em uma arena na memória principal, sem arquivo binário
+    ArvB* arv = NULL;
+    if(emMemoria) {
+        if(tamPagina > 0) ordem = ordemPorTamPagina(tamPagina);
+        if(ordem >= 3) arv = criaArvBMemoria(ordem);
+    } else {
+        arv = tamPagina > 0 ? criaArvBPagina(tamPagina) : criaArvB(ordem);
+    }
+
+    // com -b os nós internos reservam parte da página para o buffer de mensagens
+    if(arv != NULL && capacidadeBuffer > 0 && !habilitaBufferArvB(arv, capacidadeBuffer)) {
+        liberaArvB(arv);
+        return NULL;
+    }
+
+    if(arv != NULL && chavesEsperadasFiltro > 0) habilitaFiltroArvB(arv, chavesEsperadasFiltro, TAXA_FALSO_POSITIVO_FILTRO);
+    return arv;
+}
+
+static double tempoAtual() {
+    struct timespec t;
+    timespec_get(&t, TIME_UTC);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void iniciaAnelEspera(AnelEspera* a, int tamElemento) {
+    a->anel = criaAnel(CAPACIDADE_ANEL, tamElemento);
+    pthread_mutex_init(&a->mutex, NULL);
+    for(int i = 0; i < 2; i++) {
+        pthread_cond_init(&a->cond[i], NULL);
+        atomic_init(&a->bloqueada[i], 0);
+    }
+}
+
+static void finalizaAnelEspera(AnelEspera* a) {
+    liberaAnel(a->anel);
+    pthread_mutex_destroy(&a->mutex);
+    pthread_cond_destroy(&a->cond[0]);
+    pthread_cond_destroy(&a->cond[1]);
+}
+
+// Tenta inserir (ou retirar) o elemento uma vez
+static int tentaAnel(AnelEspera* a, int insercao, void* elemento) {
+    return insercao ? insereAnel(a->anel, elemento) : retiraAnel(a->anel, elemento);
+}
+
+// Repete a inserção (ou retirada) até que ela tenha sucesso: primeiro cedendo o processador por um número limitado de
+// tentativas e depois bloqueando na condição da ponta. A marca 'bloqueada' é publicada antes da tentativa seguinte (com
+// barreiras nas duas pontas), então ou essa tentativa vê o que a outra ponta fez, ou a outra ponta vê a marca e
+// sinaliza; como o sinal exige a trava, ele não se perde entre a tentativa e a espera.
+static void esperaAnel(AnelEspera* a, int insercao, void* elemento) {
+    for(int i = 0; i < LIMITE_ESPERA_ATIVA; i++) {
+        sched_yield();
+        if(tentaAnel(a, insercao, elemento)) return;
+    }
+
+    pthread_mutex_lock(&a->mutex);
+    atomic_store_explicit(&a->bloqueada[insercao], 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    while(!tentaAnel(a, insercao, elemento)) pthread_cond_wait(&a->cond[insercao], &a->mutex);
+    atomic_store_explicit(&a->bloqueada[insercao], 0, memory_order_relaxed);
+    pthread_mutex_unlock(&a->mutex);
+}
+
+// Acorda a ponta indicada do anel se ela estiver bloqueada (chamada pela outra ponta após cada inserção ou retirada)
+static void sinalizaAnel(AnelEspera* a, int ponta) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if(!atomic_load_explicit(&a->bloqueada[ponta], memory_order_relaxed)) return;
+
+    pthread_mutex_lock(&a->mutex);
+    pthread_cond_signal(&a->cond[ponta]);
+    pthread_mutex_unlock(&a->mutex);
+}
+
+// Insere o elemento no anel, esperando (ver esperaAnel) enquanto ele estiver cheio
+static void insereAnelEspera(AnelEspera* a, const void* elemento, ContadoresEtapa* c) {
+    if(!insereAnel(a->anel, elemento)) {
+        c->esperasSaida++;
+        double inicio = tempoAtual();
+        esperaAnel(a, 1, (void*)elemento);
+        c->tempoEspera += tempoAtual() - inicio;
+    }
+    sinalizaAnel(a, 0);
+}
+
+// Retira um elemento do anel, esperando (ver esperaAnel) enquanto ele estiver vazio
+static void retiraAnelEspera(AnelEspera* a, void* elemento, ContadoresEtapa* c) {
+    if(!retiraAnel(a->anel, elemento)) {
+        c->esperasEntrada++;
+        double inicio = tempoAtual();
+        esperaAnel(a, 0, elemento);
+        c->tempoEspera += tempoAtual() - inicio;
+    }
+    sinalizaAnel(a, 1);
+}
+
+// Etapa de leitura: interpreta as linhas do arquivo de entrada e as agrupa em blocos de comandos
+static void etapaLeitura(Pipeline* p) {
+    double inicio = tempoAtual();
+    BlocoComandos bloco = {.fim = 0, .numComandos = 0};
+
+    for(int i = 0; i < p->numOperacoes; i++) {
+        Comando* cmd = &bloco.comandos[bloco.numComandos];
+        cmd->operacao = 0;
+        fscanf(p->arqEntrada, "%c", &cmd->operacao);
+
+        switch (cmd->operacao) {
+        case 'I':
+        case 'A':
+        case 'S':
+            fscanf(p->arqEntrada, "%d, %d", &cmd->chave,  &cmd->registro);
+            break;
+        
+        case 'C':
+            fscanf(p->arqEntrada, "%d, %d, %d", &cmd->chave, &cmd->esperado, &cmd->registro);
+            break;
+        
+        case 'D':
+            fscanf(p->arqEntrada, "%d, %d", &cmd->chave, &cmd->chaveMax);
+            break;
+        
+        case 'R':
+        case 'B':
+        case 'X':
+            fscanf(p->arqEntrada, "%d", &cmd->chave);
+            break;
+        
+        default:
+            break;
+        }
+
+        fscanf(p->arqEntrada, "%*[^\n]"); fscanf(p->arqEntrada, "%*c");
+
+        p->leitura.itens++;
+        if(++bloco.numComandos == TAM_BLOCO_COMANDOS) {
+            insereAnelEspera(&p->comandos, &bloco, &p->leitura);
+            bloco.numComandos = 0;
+        }
+    }
+
+    if(bloco.numComandos > 0) insereAnelEspera(&p->comandos, &bloco, &p->leitura);
+    bloco.fim = 1;
+    bloco.numComandos = 0;
+    insereAnelEspera(&p->comandos, &bloco, &p->leitura);
+
+    p->leitura.tempoTotal = tempoAtual() - inicio;
+}
+
+// Etapa de execução: aplica os comandos à árvore, na ordem da entrada, e repassa os resultados dos que geram saída
+static void* etapaExecucao(void* arg) {
+    Pipeline* p = arg;
+    double inicio = tempoAtual();
+    BlocoComandos bloco;
+    BlocoResultados resultados;
+
+    do {
+        retiraAnelEspera(&p->comandos, &bloco, &p->execucao);
+        resultados.fim = bloco.fim;
+        resultados.numResultados = 0;
+
+        for(int i = 0; i < bloco.numComandos; i++) {
+            Comando* cmd = &bloco.comandos[i];
+            Resultado* r = &resultados.resultados[resultados.numResultados];
+            r->operacao = cmd->operacao;
+            r->registro = 0;
+            switch (cmd->operacao) {
+            case 'I':
+                if(p->arvP) insereParticionada(p->arvP, cmd->chave, cmd->registro);
+                else insereChaveValor(p->arvB, cmd->chave, cmd->registro);
+                break;
+            
+            case 'R':
+                if(p->arvP) removeParticionada(p->arvP, cmd->chave);
+                else removeChaveValor(p->arvB, cmd->chave);
+                break;
+            
+            case 'D':
+                if(p->arvP) removeIntervaloParticionada(p->arvP, cmd->chave, cmd->chaveMax);
+                else removeIntervalo(p->arvB, cmd->chave, cmd->chaveMax);
+                break;
+            
+            case 'B':
+                r->sucesso = p->arvP ? buscaParticionada(p->arvP, cmd->chave, &r->registro)
+                                     : buscaChave(p->arvB, cmd->chave, &r->registro);
+                resultados.numResultados++;
+                break;
+            
+            case 'A':
+                r->sucesso = p->arvP ? insereSeAusenteParticionada(p->arvP, cmd->chave, cmd->registro, &r->registro)
+                                     : insereSeAusente(p->arvB, cmd->chave, cmd->registro, &r->registro);
+                resultados.numResultados++;
+                break;
+            
+            case 'C':
+                r->sucesso = p->arvP ? comparaETrocaParticionada(p->arvP, cmd->chave, cmd->esperado, cmd->registro, &r->registro)
+                                     : comparaETroca(p->arvB, cmd->chave, cmd->esperado, cmd->registro, &r->registro);
+                resultados.numResultados++;
+                break;
+            
+            case 'S':
+                r->registro = p->arvP ? acumulaRegistroParticionada(p->arvP, cmd->chave, cmd->registro)
+                                      : acumulaRegistro(p->arvB, cmd->chave, cmd->registro);
+                resultados.numResultados++;
+                break;
+            
+            case 'X':
+                r->sucesso = p->arvP ? removeERetornaParticionada(p->arvP, cmd->chave, &r->registro)
+                                     : removeERetorna(p->arvB, cmd->chave, &r->registro);
+                resultados.numResultados++;
+                break;
+            
+            default:
+                break;
+            }
+        }
+        p->execucao.itens += bloco.numComandos;
+
+        // blocos sem comandos que geram saída não têm o que repassar, exceto o de fim
+        if(resultados.numResultados > 0 || resultados.fim) insereAnelEspera(&p->resultados, &resultados, &p->execucao);
+    } while(!bloco.fim);
+
+    p->execucao.tempoTotal = tempoAtual() - inicio;
+    return NULL;
+}
+
+// Escreve a mensagem correspondente ao resultado de um comando
+static void escreveResultado(FILE* arqSaida, Resultado* r) {
+    switch (r->operacao) {
+    case 'B':
+        fprintf(arqSaida, r->sucesso ? MSG_REGISTRO_ENCONTRADO : MSG_REGISTRO_NAO_ENCONTRADO);
+        break;
+    
+    case 'A':
+        if(r->sucesso) fprintf(arqSaida, MSG_REGISTRO_INSERIDO);
+        else fprintf(arqSaida, MSG_REGISTRO_JA_PRESENTE, r->registro);
+        break;
+    
+    case 'C':
+        if(r->sucesso < 0) fprintf(arqSaida, MSG_REGISTRO_NAO_ENCONTRADO);
+        else if(r->sucesso) fprintf(arqSaida, MSG_REGISTRO_TROCADO);
+        else fprintf(arqSaida, MSG_REGISTRO_NAO_TROCADO, r->registro);
+        break;
+    
+    case 'S':
+        fprintf(arqSaida, MSG_REGISTRO_ACUMULADO, r->registro);
+        break;
+    
+    case 'X':
+        if(r->sucesso) fprintf(arqSaida, MSG_REGISTRO_REMOVIDO, r->registro);
+        else fprintf(arqSaida, MSG_REGISTRO_NAO_ENCONTRADO);
+        break;
+    
+    default:
+        break;
+    }
+}
+
+// Etapa de saída: escreve os resultados dos comandos, em ordem, e, após o fim da execução, a impressão da árvore
+static void* etapaSaida(void* arg) {
+    Pipeline* p = arg;
+    double inicio = tempoAtual();
+    BlocoResultados resultados;
+    int flagBusca = 0;
+
+    do {
+        retiraAnelEspera(&p->resultados, &resultados, &p->saida);
+
+        for(int i = 0; i < resultados.numResultados; i++) {
+            flagBusca = 1;
+            escreveResultado(p->arqSaida, &resultados.resultados[i]);
+        }
+        p->saida.itens += resultados.numResultados;
+    } while(!resultados.fim);
+
+    // o bloco de fim só é enviado depois do último comando aplicado, então a árvore não é mais modificada
+    if(flagBusca) fprintf(p->arqSaida, "\n");
+    if(p->arvP) imprimeArvBParticionada(p->arvP, p->arqSaida);
+    else imprimeArvB(p->arvB, p->arqSaida);
+
+    p->saida.tempoTotal = tempoAtual() - inicio;
+    return NULL;
+}
+
+static void imprimeContadoresEtapa(const char* nome, ContadoresEtapa* c) {
+    double tempoAtivo = c->tempoTotal - c->tempoEspera;
+    printf("%-8s itens: %9ld | %12.0f itens/s ativos | esperas entrada: %7ld | esperas saida: %7ld | em espera: %5.1f%%\n",
+           nome, c->itens, tempoAtivo > 0 ? c->itens / tempoAtivo : 0, c->esperasEntrada, c->esperasSaida,
+           c->tempoTotal > 0 ? 100 * c->tempoEspera / c->tempoTotal : 0);
+}
 
 int main(int argc, char const *argv[]) {
-    if(argc != 3) {
+    // --- LEITURA DAS OPÇÕES
+    int tamPagina = 0; // 0: ordem lida do arquivo de entrada
+    int emMemoria = 0;
+    int chavesEsperadasFiltro = 0; // 0: sem filtro de pertinência
+    int numParticoes = 0; // 0: uma única árvore, sem threads
+    int chaveMaxima = -1; // -1: não informada
+    int exibeContadores = 0;
+    int capacidadeBuffer = 0; // 0: sem buffers de mensagens
+    int argsValidos = argc >= 3;
+    for(int i = 3; i < argc && argsValidos; i++) {
+        if(strcmp(argv[i], "-p") == 0 && i+1 < argc) {
+            tamPagina = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-m") == 0) {
+            emMemoria = 1;
+        } else if(strcmp(argv[i], "-f") == 0 && i+1 < argc) {
+            chavesEsperadasFiltro = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-s") == 0 && i+1 < argc) {
+            numParticoes = atoi(argv[++i]);
+            argsValidos = numParticoes > 0;
+        } else if(strcmp(argv[i], "-k") == 0 && i+1 < argc) {
+            chaveMaxima = atoi(argv[++i]);
+            argsValidos = chaveMaxima >= 0;
+        } else if(strcmp(argv[i], "-b") == 0 && i+1 < argc) {
+            capacidadeBuffer = atoi(argv[++i]);
+            argsValidos = capacidadeBuffer > 0;
+        } else if(strcmp(argv[i], "-e") == 0) {
+            exibeContadores = 1;
+        } else {
+            argsValidos = 0;
+        }
+    }
+
+    if(capacidadeBuffer > 0 && chavesEsperadasFiltro > 0) argsValidos = 0; // o filtro não é mantido no modo bufferizado
+
+    // as partições dividem [0, chaveMaxima] em faixas iguais; sem um limite real, todas as chaves cairiam na primeira
+    if(numParticoes > 1 && chaveMaxima < 0) {
+        printf("A opcao -s com mais de uma particao exige a chave maxima (-k).\n");
+        argsValidos = 0;
+    }
+    if(chaveMaxima < 0) chaveMaxima = INT_MAX;
+
+    if(!argsValidos) {
         printf("Chamada incorreta.\n");
-        printf("Formato esperado: <nome_executavel> <nome_arquivo_entrada> <nome_arquivo_saida>\n");
+        printf("Formato esperado: <nome_executavel> <nome_arquivo_entrada> <nome_arquivo_saida> [-p <tam_pagina>] [-m] [-f <chaves_esperadas>] [-b <capacidade_buffer>] [-s <num_particoes> -k <chave_maxima>] [-e]\n");
         return 1;
     }
+    // ---
 
     // --- ABERTURA DE ARQUIVOS
     FILE* arqEntrada = fopen(argv[1], "r");
@@ -43,47 +462,57 @@ int main(int argc, char const *argv[]) {
 
     if(ordemArvB < 3) ordemArvB = 3;
 
-    ArvB* arvB = criaArvB(ordemArvB);
+    // com -s a estrutura é dividida em partições, cada uma com a sua árvore (e o seu arq. bin.) e a sua thread
+    ArvB* arvB = NULL;
+    ArvBParticionada* arvP = NULL;
+    if(numParticoes == 0) {
+        arvB = criaArvBOpcoes(ordemArvB, tamPagina, emMemoria, chavesEsperadasFiltro, capacidadeBuffer);
+    } else {
+        ArvB** arvores = malloc(numParticoes * sizeof(ArvB*));
+        int chavesFiltroParticao = (chavesEsperadasFiltro + numParticoes - 1) / numParticoes;
+        for(int i = 0; i < numParticoes; i++) {
+            arvores[i] = criaArvBOpcoes(ordemArvB, tamPagina, emMemoria, chavesFiltroParticao, capacidadeBuffer);
+            if(arvores[i] == NULL) break;
 
-    char operacao = 0;
-    int chave = 0, registro = 0, flagBusca = 0;
-    for(int i = 0; i < numOperacoes; i++) {
-        fscanf(arqEntrada, "%c", &operacao);
-
-        switch (operacao) {
-        case 'I':
-            fscanf(arqEntrada, "%d, %d", &chave,  &registro);
-            insereChaveValor(arvB, chave, registro);
-            break;
-        
-        case 'R':
-            fscanf(arqEntrada, "%d", &chave);
-            removeChaveValor(arvB, chave);
-            break;
-        
-        case 'B':
-            flagBusca = 1;
-            fscanf(arqEntrada, "%d", &chave);
-            int registro = 0;
-            if(buscaChave(arvB, chave, &registro)) {
-                fprintf(arqSaida, MSG_REGISTRO_ENCONTRADO);
-            } else {
-                fprintf(arqSaida, MSG_REGISTRO_NAO_ENCONTRADO);
-            }
-            break;
-        
-        default:
-            break;
+            char nomeArqParticao[TAM_NOME_ARQ_PARTICAO];
+            sprintf(nomeArqParticao, "arvB_%d.bin", i);
+            defineArqBinArvB(arvores[i], nomeArqParticao);
         }
+        if(arvores[0] != NULL) arvP = criaArvBParticionada(arvores, numParticoes, chaveMaxima, CAPACIDADE_FILA_PARTICAO);
+        free(arvores);
+    }
 
-        fscanf(arqEntrada, "%*[^\n]"); fscanf(arqEntrada, "%*c");
+    if(arvB == NULL && arvP == NULL) {
+        printf("Tamanho de pagina '%d' insuficiente para um no da arvore.\n", tamPagina);
+        fclose(arqEntrada);
+        fclose(arqSaida);
+        return 1;
     }
 
-    if(flagBusca) fprintf(arqSaida, "\n");
-    imprimeArvB(arvB, arqSaida);
+    // leitura (nesta thread), execução e saída rodam em paralelo, ligadas por anéis sem travas
+    Pipeline p = {.arqEntrada = arqEntrada, .arqSaida = arqSaida, .numOperacoes = numOperacoes, .arvB = arvB,
+                  .arvP = arvP};
+    iniciaAnelEspera(&p.comandos, sizeof(BlocoComandos));
+    iniciaAnelEspera(&p.resultados, sizeof(BlocoResultados));
+
+    pthread_t threadExecucao, threadSaida;
+    pthread_create(&threadExecucao, NULL, etapaExecucao, &p);
+    pthread_create(&threadSaida, NULL, etapaSaida, &p);
+    etapaLeitura(&p);
+    pthread_join(threadExecucao, NULL);
+    pthread_join(threadSaida, NULL);
+
+    if(exibeContadores) {
+        imprimeContadoresEtapa("leitura", &p.leitura);
+        imprimeContadoresEtapa("execucao", &p.execucao);
+        imprimeContadoresEtapa("saida", &p.saida);
+    }
 
     // --- LIBERAÇÃO DE MEMÓRIA
     liberaArvB(arvB);   
+    liberaArvBParticionada(arvP);
+    finalizaAnelEspera(&p.comandos);
+    finalizaAnelEspera(&p.resultados);
     fclose(arqEntrada);
     fclose(arqSaida);
     // ---
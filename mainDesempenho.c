@@ -0,0 +1,60 @@
+/**
+ * @file    mainDesempenho.c
+ * @brief   Arquivo cliente responsável por executar as medições de desempenho da árvore B a partir da linha de comando.
+ * @author  Daniel Corona de Aguiar (daniel.aguiar@edu.ufes.br/2023101578)
+ * @author  João Pedro Pereira Loss (joao.loss@edu.ufes.br/2023102068)
+ * @author  Raphael Correia Dornelas (raphael.dornelas@edu.ufes.br/2023100595)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "desempenho.h"
+
+#define NOME_ARQ_CALIBRACAO "arvB_calibracao.bin"
+#define MAX_TAMANHOS 32
+
+int main(int argc, char const *argv[]) {
+    int calibracao = argc >= 4 && strcmp(argv[1], "calibra") == 0;
+    int comparacao = argc == 5 && strcmp(argv[1], "modos") == 0;
+    if(!calibracao && !comparacao) {
+        printf("Chamada incorreta.\n");
+        printf("Formatos esperados:\n");
+        printf("  <nome_executavel> calibra <fracao_escrita> <num_operacoes> [tam_pagina ...]\n");
+        printf("  <nome_executavel> modos <fracao_escrita> <num_operacoes> <ordem>\n");
+        return 1;
+    }
+
+    double fracaoEscrita = atof(argv[2]);
+    int numOperacoes = atoi(argv[3]);
+
+    if(comparacao) {
+        double razao = comparaModosArmazenamento(atoi(argv[4]), numOperacoes, fracaoEscrita, NOME_ARQ_CALIBRACAO, stdout);
+        if(razao < 0) {
+            printf("Ordem invalida.\n");
+            return 1;
+        }
+        printf("Memoria/arquivo: %.2fx\n", razao);
+        return 0;
+    }
+
+    int tamPaginas[MAX_TAMANHOS] = {4096, 16384, 65536};
+    int numTamanhos = 3;
+    if(argc > 4) {
+        numTamanhos = 0;
+        for(int i = 4; i < argc && numTamanhos < MAX_TAMANHOS; i++) {
+            tamPaginas[numTamanhos++] = atoi(argv[i]);
+        }
+    }
+
+    int tamPagina = 0;
+    int ordem = calibraOrdem(tamPaginas, numTamanhos, numOperacoes, fracaoEscrita, NOME_ARQ_CALIBRACAO, stdout, &tamPagina);
+    if(ordem == -1) {
+        printf("Nenhum tamanho de pagina valido.\n");
+        return 1;
+    }
+    printf("Ordem recomendada: %d (-p %d)\n", ordem, tamPagina);
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../arvoreB.h"
+
+// Teste de alocações: com as chamadas a malloc, calloc, realloc e free redirecionadas para contadores (ligação com
+// -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free), verifica que, depois de uma carga de aquecimento,
+// inserções, buscas e remoções não alocam nem liberam memória, nos modos em arquivo e em memória.
+
+#define NUM_CHAVES 8000
+#define NUM_OPERACOES 20000
+
+static long numAlocacoes = 0, numLiberacoes = 0;
+
+void* __real_malloc(size_t tam);
+void* __real_calloc(size_t num, size_t tam);
+void* __real_realloc(void* p, size_t tam);
+void __real_free(void* p);
+
+void* __wrap_malloc(size_t tam) { numAlocacoes++; return __real_malloc(tam); }
+void* __wrap_calloc(size_t num, size_t tam) { numAlocacoes++; return __real_calloc(num, tam); }
+void* __wrap_realloc(void* p, size_t tam) { numAlocacoes++; return __real_realloc(p, tam); }
+void __wrap_free(void* p) { if(p) numLiberacoes++; __real_free(p); }
+
+// Aplica uma carga determinística de inserções, remoções e buscas (I/R/B, nessa proporção)
+static void executaCarga(ArvB* arv, unsigned* semente) {
+    int registro;
+    for(int i = 0; i < NUM_OPERACOES; i++) {
+        *semente = *semente * 1103515245u + 12345u;
+        int chave = (*semente >> 8) % NUM_CHAVES;
+        if(i % 3 == 0) insereChaveValor(arv, chave, i);
+        else if(i % 3 == 1) removeChaveValor(arv, chave);
+        else buscaChave(arv, chave, &registro);
+    }
+}
+
+int main() {
+    int falhas = 0;
+    for(int emMemoria = 0; emMemoria <= 1; emMemoria++) {
+        for(int ordem = 3; ordem <= 9; ordem += 3) {
+            ArvB* arv = emMemoria ? criaArvBMemoria(ordem) : criaArvB(ordem);
+            defineArqBinArvB(arv, "testeAlocacoes.bin");
+            unsigned semente = ordem;
+
+            // o aquecimento preenche a lista de nós livres (e, em memória, a arena)
+            executaCarga(arv, &semente);
+            executaCarga(arv, &semente);
+
+            long alocacoes = numAlocacoes, liberacoes = numLiberacoes;
+            executaCarga(arv, &semente);
+            alocacoes = numAlocacoes - alocacoes;
+            liberacoes = numLiberacoes - liberacoes;
+            if(alocacoes || liberacoes) {
+                printf("FALHA: modo %s, ordem %d: %ld alocações e %ld liberações após o aquecimento\n",
+                       emMemoria ? "memoria" : "arquivo", ordem, alocacoes, liberacoes);
+                falhas++;
+            }
+            liberaArvB(arv);
+        }
+    }
+    printf("testeAlocacoes: %s\n", falhas ? "FALHOU" : "ok");
+    return falhas ? 1 : 0;
+}
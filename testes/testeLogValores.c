@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "../arvoreB.h"
+
+// Teste do log de valores: valores em bytes de tamanhos variados são inseridos, sobrescritos e removidos, o log é
+// compactado e todos os valores são lidos de novo, conferindo os bytes, os bytes recuperados (pelo tamanho do arquivo
+// .vlog) e que inserções posteriores à compactação continuam no novo log, nos modos em arquivo e em memória. Também
+// verifica que um valor que faria o log passar de INT_MAX bytes é recusado sem alterar o log nem a árvore.
+
+#define NUM_CHAVES 600
+#define TAM_MAXIMO 300
+#define NOME_ARQ "testeLogValores.bin"
+#define NOME_LOG NOME_ARQ ".vlog"
+
+static int tamanhos[NUM_CHAVES]; // -1: chave ausente
+static int versoes[NUM_CHAVES];
+
+// Preenche o valor da chave em sua versão: o tamanho e os bytes dependem de ambos
+static int montaValor(int chave, int versao, char* valor) {
+    int tam = (chave * 7 + versao * 13) % TAM_MAXIMO;
+    for(int i = 0; i < tam; i++) valor[i] = (char)(chave + versao * 31 + i);
+    return tam;
+}
+
+static void insereVersao(ArvB* arv, int chave, int versao) {
+    char valor[TAM_MAXIMO];
+    tamanhos[chave] = montaValor(chave, versao, valor);
+    versoes[chave] = versao;
+    insereChaveBytes(arv, chave, valor, tamanhos[chave]);
+}
+
+static long tamArquivo(const char* nomeArq) {
+    FILE* arq = fopen(nomeArq, "rb");
+    if(arq == NULL) return -1;
+    fseek(arq, 0, SEEK_END);
+    long tam = ftell(arq);
+    fclose(arq);
+    return tam;
+}
+
+// Lê todos os valores e os compara com os esperados. Retorna o número de divergências.
+static int verificaValores(ArvB* arv) {
+    int erros = 0;
+    char valor[TAM_MAXIMO], esperado[TAM_MAXIMO];
+    for(int k = 0; k < NUM_CHAVES; k++) {
+        int tam = buscaChaveBytes(arv, k, valor, sizeof(valor));
+        if(tamanhos[k] < 0) {
+            if(tam != -1) {
+                printf("  chave removida %d ainda tem valor\n", k);
+                erros++;
+            }
+            continue;
+        }
+        montaValor(k, versoes[k], esperado);
+        if(tam != tamanhos[k] || memcmp(valor, esperado, tam) != 0) {
+            printf("  chave %d: valor divergente (tamanho %d, esperado %d)\n", k, tam, tamanhos[k]);
+            erros++;
+        }
+    }
+    return erros;
+}
+
+static int executaCaso(int emMemoria) {
+    ArvB* arv = emMemoria ? criaArvBMemoria(5) : criaArvB(5);
+    defineArqBinArvB(arv, NOME_ARQ);
+    int erros = 0;
+
+    for(int k = 0; k < NUM_CHAVES; k++) insereVersao(arv, k, 0);
+    for(int k = 0; k < NUM_CHAVES; k += 3) insereVersao(arv, k, 1); // sobrescritas
+    for(int k = 1; k < NUM_CHAVES; k += 4) { // remoções
+        removeChaveValor(arv, k);
+        tamanhos[k] = -1;
+    }
+    erros += verificaValores(arv);
+
+    long tamAntes = tamArquivo(NOME_LOG);
+    int recuperados = compactaLogValores(arv);
+    long tamDepois = tamArquivo(NOME_LOG);
+    if(recuperados <= 0 || tamAntes - tamDepois != recuperados) {
+        printf("  compactação: %d bytes recuperados, log de %ld para %ld bytes\n", recuperados, tamAntes, tamDepois);
+        erros++;
+    }
+    erros += verificaValores(arv);
+
+    // sem valores mortos, uma nova compactação não recupera nada
+    if(compactaLogValores(arv) != 0) {
+        printf("  segunda compactação recuperou bytes\n");
+        erros++;
+    }
+
+    for(int k = 0; k < NUM_CHAVES; k += 5) insereVersao(arv, k, 2); // o log compactado continua recebendo valores
+    erros += verificaValores(arv);
+
+    liberaArvB(arv);
+    if(erros) printf("FALHA: modo %s\n", emMemoria ? "memoria" : "arquivo");
+    return erros;
+}
+
+// Os deslocamentos do log são registros int: um valor grande demais é recusado antes de qualquer escrita (os seus bytes
+// nem são lidos), e a chave mantém o valor anterior
+static int executaCasoLimite(int emMemoria) {
+    ArvB* arv = emMemoria ? criaArvBMemoria(5) : criaArvB(5);
+    defineArqBinArvB(arv, NOME_ARQ);
+    int erros = 0;
+    char valor[TAM_MAXIMO];
+
+    for(int k = 0; k < 10; k++) insereVersao(arv, k, 0);
+    long tamAntes = tamArquivo(NOME_LOG);
+    if(insereChaveBytes(arv, 3, valor, INT_MAX - 4) || insereChaveBytes(arv, 20, valor, INT_MAX - (int)tamAntes)) {
+        printf("  valor que passaria de INT_MAX bytes foi aceito\n");
+        erros++;
+    }
+    if(tamArquivo(NOME_LOG) != tamAntes || buscaChaveBytes(arv, 20, NULL, 0) != -1) {
+        printf("  valor recusado alterou o log ou a árvore\n");
+        erros++;
+    }
+    erros += verificaValores(arv);
+
+    if(!insereChaveBytes(arv, 3, valor, montaValor(3, 1, valor))) { // o log continua recebendo valores
+        printf("  inserção após a recusa falhou\n");
+        erros++;
+    }
+    tamanhos[3] = montaValor(3, 1, valor);
+    versoes[3] = 1;
+    erros += verificaValores(arv);
+
+    liberaArvB(arv);
+    if(erros) printf("FALHA: limite do log, modo %s\n", emMemoria ? "memoria" : "arquivo");
+    return erros;
+}
+
+int main() {
+    int falhas = 0;
+    for(int emMemoria = 0; emMemoria <= 1; emMemoria++) {
+        falhas += executaCaso(emMemoria) != 0;
+        for(int k = 0; k < NUM_CHAVES; k++) tamanhos[k] = -1;
+        falhas += executaCasoLimite(emMemoria) != 0;
+    }
+    printf("testeLogValores: %s\n", falhas ? "FALHOU" : "ok");
+    return falhas ? 1 : 0;
+}
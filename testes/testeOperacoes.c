@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "../arvoreB.h"
+
+// Teste de modelo das operações de uma única descida (insereSeAusente, comparaETroca, acumulaRegistro e removeERetorna):
+// sequências aleatórias dessas operações, misturadas a inserções e remoções comuns, são aplicadas à árvore e a um vetor
+// de referência, e cada retorno é comparado com o esperado, para as ordens 3 a 7 nos modos em arquivo, em memória,
+// bufferizado e com filtro de pertinência. Inclui comparações de chaves ausentes (que nunca as inserem) e acúmulos que
+// saturam nos limites do int (em INT_MIN + 1 no modo bufferizado, em que INT_MIN é reservado).
+
+#define NUM_CHAVES 400
+#define NUM_OPERACOES 6000
+#define NUM_SEMENTES 2
+
+enum { MODO_ARQUIVO, MODO_MEMORIA, MODO_BUFFER, MODO_FILTRO, NUM_MODOS };
+static const char* nomesModos[NUM_MODOS] = {"arquivo", "memoria", "buffer", "filtro"};
+
+static char presente[NUM_CHAVES];
+static int registros[NUM_CHAVES];
+
+static ArvB* criaArvTeste(int modo, int ordem) {
+    ArvB* arv = modo == MODO_MEMORIA ? criaArvBMemoria(ordem) : criaArvB(ordem);
+    defineArqBinArvB(arv, "testeOperacoes.bin");
+    if(modo == MODO_FILTRO) habilitaFiltroArvB(arv, NUM_CHAVES, 0.01);
+    if(modo == MODO_BUFFER) habilitaBufferArvB(arv, 6);
+    return arv;
+}
+
+// Sorteia um registro, às vezes próximo dos limites do int para exercitar a saturação dos acúmulos
+static int sorteiaRegistro() {
+    switch(rand() % 8) {
+    case 0: return INT_MAX - rand() % 4;
+    case 1: return INT_MIN + rand() % 4;
+    default: return rand() % 2001 - 1000;
+    }
+}
+
+// Soma com saturação em INT_MAX e no menor registro permitido
+static int somaSaturada(int a, int b, int minimo) {
+    long long soma = (long long)a + b;
+    if(soma > INT_MAX) return INT_MAX;
+    if(soma < minimo) return minimo;
+    return (int)soma;
+}
+
+// Compara as buscas de todas as chaves com o vetor de referência. Retorna o número de divergências.
+static int verificaBuscas(ArvB* arv) {
+    int erros = 0;
+    for(int k = 0; k < NUM_CHAVES && !erros; k++) {
+        int registro;
+        int achou = buscaChave(arv, k, &registro);
+        if(achou != presente[k] || (achou && registro != registros[k])) {
+            printf("  buscaChave(%d): %d (%d), esperado %d (%d)\n", k, achou, registro, presente[k], registros[k]);
+            erros++;
+        }
+    }
+    return erros;
+}
+
+// Aplica uma operação sorteada à árvore e ao vetor de referência. Retorna 1 se o retorno divergir do esperado.
+static int executaOperacao(ArvB* arv, int minimo) {
+    int k = rand() % NUM_CHAVES;
+    int registro = sorteiaRegistro();
+    int atual = 0, obtido, esperado;
+
+    switch(rand() % 7) {
+    case 0: // insereSeAusente
+        if(registro < minimo) registro = minimo;
+        obtido = insereSeAusente(arv, k, registro, &atual);
+        esperado = !presente[k];
+        if(obtido != esperado || (!esperado && atual != registros[k])) {
+            printf("  insereSeAusente(%d, %d): %d (%d), esperado %d (%d)\n", k, registro, obtido, atual, esperado, registros[k]);
+            return 1;
+        }
+        if(esperado) {
+            presente[k] = 1;
+            registros[k] = registro;
+        }
+        return 0;
+
+    case 1: // comparaETroca com o registro atual (troca) ou com outro (não troca); em chave ausente, nunca insere
+    case 2: {
+        if(registro < minimo) registro = minimo;
+        int comparado = presente[k] && rand() % 2 ? registros[k] : sorteiaRegistro();
+        obtido = comparaETroca(arv, k, comparado, registro, &atual);
+        esperado = !presente[k] ? -1 : registros[k] == comparado;
+        if(obtido != esperado || (esperado >= 0 && atual != registros[k])) {
+            printf("  comparaETroca(%d, %d, %d): %d (%d), esperado %d\n", k, comparado, registro, obtido, atual, esperado);
+            return 1;
+        }
+        if(esperado == 1) registros[k] = registro;
+        return 0;
+    }
+
+    case 3: // acumulaRegistro
+    case 4:
+        esperado = presente[k] ? somaSaturada(registros[k], registro, minimo) : (registro < minimo ? minimo : registro);
+        obtido = acumulaRegistro(arv, k, registro);
+        if(obtido != esperado) {
+            printf("  acumulaRegistro(%d, %d): %d, esperado %d\n", k, registro, obtido, esperado);
+            return 1;
+        }
+        presente[k] = 1;
+        registros[k] = esperado;
+        return 0;
+
+    case 5: // removeERetorna
+        obtido = removeERetorna(arv, k, &atual);
+        if(obtido != presente[k] || (obtido && atual != registros[k])) {
+            printf("  removeERetorna(%d): %d (%d), esperado %d (%d)\n", k, obtido, atual, presente[k], registros[k]);
+            return 1;
+        }
+        presente[k] = 0;
+        return 0;
+
+    default: // inserções e remoções comuns
+        if(rand() % 2) {
+            if(registro < minimo) registro = minimo;
+            insereChaveValor(arv, k, registro);
+            presente[k] = 1;
+            registros[k] = registro;
+        } else {
+            removeChaveValor(arv, k);
+            presente[k] = 0;
+        }
+        return 0;
+    }
+}
+
+static int executaCaso(int modo, int ordem, int semente) {
+    srand(semente * 31 + ordem * 7 + modo);
+    for(int k = 0; k < NUM_CHAVES; k++) presente[k] = 0;
+    ArvB* arv = criaArvTeste(modo, ordem);
+    int minimo = modo == MODO_BUFFER ? INT_MIN + 1 : INT_MIN;
+    int erros = 0;
+
+    for(int i = 0; i < NUM_OPERACOES && !erros; i++) {
+        erros += executaOperacao(arv, minimo);
+        if(i % 500 == 499) erros += verificaBuscas(arv);
+    }
+    erros += verificaBuscas(arv);
+
+    liberaArvB(arv);
+    if(erros) printf("FALHA: modo %s, ordem %d, semente %d\n", nomesModos[modo], ordem, semente);
+    return erros;
+}
+
+int main() {
+    int falhas = 0;
+    for(int modo = 0; modo < NUM_MODOS; modo++) {
+        for(int ordem = 3; ordem <= 7; ordem++) {
+            for(int semente = 0; semente < NUM_SEMENTES; semente++) {
+                falhas += executaCaso(modo, ordem, semente) != 0;
+            }
+        }
+    }
+    printf("testeOperacoes: %s\n", falhas ? "FALHOU" : "ok");
+    return falhas ? 1 : 0;
+}
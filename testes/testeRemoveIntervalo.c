@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../arvoreB.h"
+
+// Teste de modelo da remoção por intervalo: sequências aleatórias de inserções, remoções e remoções por intervalo são
+// aplicadas à árvore e a um vetor de referência, e as consultas (busca, contagem, posto e seleção) são comparadas com
+// ele após cada rodada, para as ordens 3 a 7 nos modos em arquivo, em memória, bufferizado e com filtro de pertinência.
+// Também verifica que as posições dos nós descartados são reaproveitadas: ciclos de inserções e cortes não fazem o
+// arquivo binário crescer indefinidamente.
+
+#define NUM_CHAVES 1000
+#define NUM_RODADAS 25
+#define NUM_SEMENTES 2
+
+enum { MODO_ARQUIVO, MODO_MEMORIA, MODO_BUFFER, MODO_FILTRO, NUM_MODOS };
+static const char* nomesModos[NUM_MODOS] = {"arquivo", "memoria", "buffer", "filtro"};
+
+static char presente[NUM_CHAVES];
+static int registros[NUM_CHAVES];
+
+static ArvB* criaArvTeste(int modo, int ordem) {
+    ArvB* arv = modo == MODO_MEMORIA ? criaArvBMemoria(ordem) : criaArvB(ordem);
+    defineArqBinArvB(arv, "testeRemoveIntervalo.bin");
+    if(modo == MODO_FILTRO) habilitaFiltroArvB(arv, NUM_CHAVES, 0.01);
+    if(modo == MODO_BUFFER) habilitaBufferArvB(arv, 6);
+    return arv;
+}
+
+// Compara todas as consultas com o vetor de referência. Retorna o número de divergências.
+static int verificaConsultas(ArvB* arv) {
+    int erros = 0, anterior = 0;
+    for(int k = 0; k < NUM_CHAVES; k++) {
+        int registro;
+        int achou = buscaChave(arv, k, &registro);
+        if(achou != presente[k] || (achou && registro != registros[k])) {
+            printf("  buscaChave(%d): %d, esperado %d\n", k, achou, presente[k]);
+            erros++;
+        }
+        if(rankChave(arv, k) != anterior) {
+            printf("  rankChave(%d): %d, esperado %d\n", k, rankChave(arv, k), anterior);
+            erros++;
+        }
+        if(presente[k]) {
+            int chave;
+            if(!selecionaK(arv, anterior, &chave, &registro) || chave != k || registro != registros[k]) {
+                printf("  selecionaK(%d): esperada a chave %d\n", anterior, k);
+                erros++;
+            }
+            anterior++;
+        }
+        if(erros) return erros;
+    }
+    if(selecionaK(arv, anterior, NULL, NULL)) {
+        printf("  selecionaK(%d) encontrou uma chave além do total\n", anterior);
+        erros++;
+    }
+    for(int i = 0; i < 20 && !erros; i++) {
+        int a = rand() % NUM_CHAVES, b = a + rand() % (NUM_CHAVES / 4);
+        int esperado = 0;
+        for(int k = a; k <= b && k < NUM_CHAVES; k++) esperado += presente[k];
+        if(contaIntervalo(arv, a, b) != esperado) {
+            printf("  contaIntervalo(%d, %d): %d, esperado %d\n", a, b, contaIntervalo(arv, a, b), esperado);
+            erros++;
+        }
+    }
+    return erros;
+}
+
+static int executaCaso(int modo, int ordem, int semente) {
+    srand(semente * 31 + ordem * 7 + modo);
+    for(int k = 0; k < NUM_CHAVES; k++) presente[k] = 0;
+    ArvB* arv = criaArvTeste(modo, ordem);
+    int erros = 0;
+
+    for(int rodada = 0; rodada < NUM_RODADAS && !erros; rodada++) {
+        int numOperacoes = rand() % NUM_CHAVES;
+        for(int i = 0; i < numOperacoes; i++) {
+            int k = rand() % NUM_CHAVES;
+            if(rand() % 4) {
+                registros[k] = k * 7 + rodada;
+                insereChaveValor(arv, k, registros[k]);
+                presente[k] = 1;
+            } else {
+                removeChaveValor(arv, k);
+                presente[k] = 0;
+            }
+        }
+
+        // intervalos de todos os tamanhos, inclusive vazios, unitários, fora das chaves e cobrindo a árvore inteira
+        int a = rand() % NUM_CHAVES - 5;
+        int b = a + (rand() % 3 ? rand() % (NUM_CHAVES / 2) : rand() % 5);
+        if(rand() % 15 == 0) { a = -3; b = NUM_CHAVES + 5; }
+        int esperado = 0;
+        for(int k = a < 0 ? 0 : a; k <= b && k < NUM_CHAVES; k++) {
+            esperado += presente[k];
+            presente[k] = 0;
+        }
+        int removidas = removeIntervalo(arv, a, b);
+        if(removidas != esperado) {
+            printf("  removeIntervalo(%d, %d): %d, esperado %d\n", a, b, removidas, esperado);
+            erros++;
+        }
+        erros += verificaConsultas(arv);
+    }
+
+    liberaArvB(arv);
+    if(erros) printf("FALHA: modo %s, ordem %d, semente %d\n", nomesModos[modo], ordem, semente);
+    return erros;
+}
+
+static long tamArquivo(const char* nomeArq) {
+    FILE* arq = fopen(nomeArq, "rb");
+    if(arq == NULL) return -1;
+    fseek(arq, 0, SEEK_END);
+    long tam = ftell(arq);
+    fclose(arq);
+    return tam;
+}
+
+// Repete ciclos que reinserem as chaves e cortam metade delas (e, com remoções comuns, esvaziam nós): a partir do
+// segundo ciclo, os nós novos ocupam as posições liberadas e o arquivo binário só varia com o pico de nós de cada ciclo
+// (sem o reaproveitamento, ele cresce cerca de um terço por ciclo)
+static int executaCasoReaproveitamento(int modo, int ordem) {
+    ArvB* arv = criaArvTeste(modo, ordem);
+    long tamSegundoCiclo = 0;
+    int erros = 0;
+
+    for(int ciclo = 0; ciclo < 10; ciclo++) {
+        for(int k = 0; k < NUM_CHAVES; k++) insereChaveValor(arv, k, k);
+        int a = (ciclo * 137) % (NUM_CHAVES / 2);
+        removeIntervalo(arv, a, a + NUM_CHAVES / 2);
+        for(int k = 0; k < NUM_CHAVES; k += 3) removeChaveValor(arv, k);
+        descarregaBuffersArvB(arv);
+
+        if(ciclo == 1) tamSegundoCiclo = tamArquivo("testeRemoveIntervalo.bin");
+        else if(ciclo > 1 && tamArquivo("testeRemoveIntervalo.bin") > tamSegundoCiclo + tamSegundoCiclo / 10) {
+            printf("  ciclo %d: arquivo binário de %ld bytes, %ld no segundo ciclo\n", ciclo,
+                   tamArquivo("testeRemoveIntervalo.bin"), tamSegundoCiclo);
+            erros++;
+            break;
+        }
+    }
+
+    liberaArvB(arv);
+    if(erros) printf("FALHA: reaproveitamento, modo %s, ordem %d\n", nomesModos[modo], ordem);
+    return erros;
+}
+
+int main() {
+    int falhas = 0;
+    for(int ordem = 3; ordem <= 7; ordem++) {
+        falhas += executaCasoReaproveitamento(MODO_ARQUIVO, ordem) != 0;
+        falhas += executaCasoReaproveitamento(MODO_BUFFER, ordem) != 0;
+    }
+    for(int modo = 0; modo < NUM_MODOS; modo++) {
+        for(int ordem = 3; ordem <= 7; ordem++) {
+            for(int semente = 0; semente < NUM_SEMENTES; semente++) {
+                falhas += executaCaso(modo, ordem, semente) != 0;
+            }
+        }
+    }
+    printf("testeRemoveIntervalo: %s\n", falhas ? "FALHOU" : "ok");
+    return falhas ? 1 : 0;
+}
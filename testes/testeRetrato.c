@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include "../arvoreB.h"
+
+// Teste dos retratos (salvaArvB/carregaArvB): árvores nos modos em arquivo, em memória, bufferizado e com filtro de
+// pertinência recebem inserções, remoções e remoções por intervalo, são salvas e recarregadas, e a árvore recarregada é
+// comparada com um vetor de referência, antes e depois de novas operações. Também verifica que arquivos inexistentes,
+// truncados, com o cabeçalho alterado ou sem o filtro salvo junto são recusados e que uma gravação que falha retorna 0.
+
+#define NUM_CHAVES 2000
+#define NOME_RETRATO "testeRetrato.snap"
+#define NOME_FILTRO NOME_RETRATO ".filtro"
+
+enum { MODO_ARQUIVO, MODO_MEMORIA, MODO_BUFFER, MODO_FILTRO, NUM_MODOS };
+static const char* nomesModos[NUM_MODOS] = {"arquivo", "memoria", "buffer", "filtro"};
+
+static char presente[NUM_CHAVES];
+static int registros[NUM_CHAVES];
+
+static ArvB* criaArvTeste(int modo, int ordem) {
+    ArvB* arv = modo == MODO_MEMORIA ? criaArvBMemoria(ordem) : criaArvB(ordem);
+    defineArqBinArvB(arv, "testeRetrato.bin");
+    if(modo == MODO_FILTRO) habilitaFiltroArvB(arv, NUM_CHAVES, 0.01);
+    if(modo == MODO_BUFFER) habilitaBufferArvB(arv, 6);
+    return arv;
+}
+
+// Aplica inserções e remoções aleatórias e uma remoção por intervalo à árvore e ao vetor de referência
+static void aplicaCarga(ArvB* arv, int numOperacoes) {
+    for(int i = 0; i < numOperacoes; i++) {
+        int k = rand() % NUM_CHAVES;
+        if(rand() % 4) {
+            registros[k] = rand() % 100000;
+            insereChaveValor(arv, k, registros[k]);
+            presente[k] = 1;
+        } else {
+            removeChaveValor(arv, k);
+            presente[k] = 0;
+        }
+    }
+    int a = rand() % NUM_CHAVES, b = a + rand() % (NUM_CHAVES / 8);
+    for(int k = a; k <= b && k < NUM_CHAVES; k++) presente[k] = 0;
+    removeIntervalo(arv, a, b);
+}
+
+// Compara as buscas e os postos com o vetor de referência. Retorna o número de divergências.
+static int verificaArvore(ArvB* arv) {
+    int erros = 0, anterior = 0;
+    for(int k = 0; k < NUM_CHAVES && !erros; k++) {
+        int registro;
+        int achou = buscaChave(arv, k, &registro);
+        if(achou != presente[k] || (achou && registro != registros[k])) {
+            printf("  buscaChave(%d): %d, esperado %d\n", k, achou, presente[k]);
+            erros++;
+        }
+        if(rankChave(arv, k) != anterior) {
+            printf("  rankChave(%d): %d, esperado %d\n", k, rankChave(arv, k), anterior);
+            erros++;
+        }
+        anterior += presente[k];
+    }
+    return erros;
+}
+
+static int executaCaso(int modo, int ordem) {
+    srand(ordem * 13 + modo);
+    for(int k = 0; k < NUM_CHAVES; k++) presente[k] = 0;
+    ArvB* arv = criaArvTeste(modo, ordem);
+    int erros = 0;
+
+    aplicaCarga(arv, NUM_CHAVES * 2);
+    if(!salvaArvB(arv, NOME_RETRATO)) {
+        printf("  salvaArvB falhou\n");
+        erros++;
+    }
+    liberaArvB(arv);
+
+    arv = carregaArvB(NOME_RETRATO);
+    if(arv == NULL) {
+        printf("FALHA: modo %s, ordem %d: retrato não recarregado\n", nomesModos[modo], ordem);
+        return 1;
+    }
+    erros += verificaArvore(arv);
+
+    // com o filtro recarregado, as buscas de chaves ausentes terminam sem ler nós
+    if(modo == MODO_FILTRO) {
+        long negativas = 0;
+        estatisticasFiltroArvB(arv, NULL, &negativas, NULL);
+        if(negativas == 0) {
+            printf("  filtro não recarregado\n");
+            erros++;
+        }
+    }
+
+    // a árvore recarregada continua funcionando, inclusive reaproveitando as posições livres salvas no retrato
+    aplicaCarga(arv, NUM_CHAVES);
+    erros += verificaArvore(arv);
+
+    liberaArvB(arv);
+    if(erros) printf("FALHA: modo %s, ordem %d\n", nomesModos[modo], ordem);
+    return erros;
+}
+
+static long tamArquivo(const char* nomeArq) {
+    FILE* arq = fopen(nomeArq, "rb");
+    if(arq == NULL) return -1;
+    fseek(arq, 0, SEEK_END);
+    long tam = ftell(arq);
+    fclose(arq);
+    return tam;
+}
+
+// Copia os 'tam' primeiros bytes do retrato para 'destino', alterando o byte 'posAlterada' (se não for negativo)
+static void copiaRetrato(const char* destino, long tam, long posAlterada) {
+    FILE* origem = fopen(NOME_RETRATO, "rb");
+    FILE* copia = fopen(destino, "wb");
+    for(long i = 0; i < tam; i++) {
+        int c = fgetc(origem);
+        fputc(i == posAlterada ? c ^ 0x5a : c, copia);
+    }
+    fclose(origem);
+    fclose(copia);
+}
+
+// Retratos inválidos são recusados, e gravações que falham retornam 0
+static int executaCasosInvalidos() {
+    int erros = 0;
+    for(int k = 0; k < NUM_CHAVES; k++) presente[k] = 0;
+    ArvB* arv = criaArvTeste(MODO_FILTRO, 5);
+    aplicaCarga(arv, NUM_CHAVES);
+    salvaArvB(arv, NOME_RETRATO);
+    long tam = tamArquivo(NOME_RETRATO);
+
+    if(carregaArvB("testeRetratoInexistente.snap") != NULL) {
+        printf("  retrato inexistente foi carregado\n");
+        erros++;
+    }
+
+    // truncado no cabeçalho, no meio dos nós e no último byte; cabeçalho alterado em cada campo
+    long cortes[] = {0, 10, tam / 2, tam - 1};
+    for(int i = 0; i < 4; i++) {
+        copiaRetrato("testeRetratoInvalido.snap", cortes[i], -1);
+        ArvB* carregada = carregaArvB("testeRetratoInvalido.snap");
+        if(carregada != NULL) {
+            printf("  retrato truncado em %ld bytes foi carregado\n", cortes[i]);
+            liberaArvB(carregada);
+            erros++;
+        }
+    }
+    for(long pos = 0; pos < 8 * (long)sizeof(int); pos += sizeof(int)) {
+        copiaRetrato("testeRetratoInvalido.snap", tam, pos);
+        rename(NOME_FILTRO, "testeRetratoInvalido.snap.filtro");
+        ArvB* carregada = carregaArvB("testeRetratoInvalido.snap");
+        rename("testeRetratoInvalido.snap.filtro", NOME_FILTRO);
+        if(carregada != NULL) {
+            printf("  retrato com o byte %ld do cabeçalho alterado foi carregado\n", pos);
+            liberaArvB(carregada);
+            erros++;
+        }
+    }
+    remove("testeRetratoInvalido.snap");
+
+    // o cabeçalho indica um filtro que não está ao lado do retrato
+    rename(NOME_FILTRO, "testeRetratoFiltro.tmp");
+    if(carregaArvB(NOME_RETRATO) != NULL) {
+        printf("  retrato sem o seu filtro foi carregado\n");
+        erros++;
+    }
+    rename("testeRetratoFiltro.tmp", NOME_FILTRO);
+
+    // gravações que falham: diretório inexistente e arquivo limitado a menos bytes que o retrato (RLIMIT_FSIZE), caso
+    // em que o retrato incompleto é apagado
+    if(salvaArvB(arv, "diretorioInexistente/testeRetrato.snap")) {
+        printf("  salvaArvB em diretório inexistente retornou 1\n");
+        erros++;
+    }
+    struct rlimit limite;
+    getrlimit(RLIMIT_FSIZE, &limite);
+    struct rlimit limiteReduzido = {.rlim_cur = tam / 2, .rlim_max = limite.rlim_max};
+    signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &limiteReduzido);
+    int salvo = salvaArvB(arv, "testeRetratoIncompleto.snap");
+    setrlimit(RLIMIT_FSIZE, &limite);
+    if(salvo || tamArquivo("testeRetratoIncompleto.snap") != -1) {
+        printf("  salvaArvB além do limite de tamanho retornou %d ou deixou o arquivo\n", salvo);
+        erros++;
+    }
+
+    liberaArvB(arv);
+    remove(NOME_RETRATO);
+    remove(NOME_FILTRO);
+    if(erros) printf("FALHA: retratos inválidos\n");
+    return erros;
+}
+
+int main() {
+    int falhas = 0;
+    for(int modo = 0; modo < NUM_MODOS; modo++) {
+        for(int ordem = 3; ordem <= 7; ordem += 2) {
+            falhas += executaCaso(modo, ordem) != 0;
+        }
+    }
+    falhas += executaCasosInvalidos() != 0;
+    remove(NOME_RETRATO);
+    remove(NOME_FILTRO);
+    printf("testeRetrato: %s\n", falhas ? "FALHOU" : "ok");
+    return falhas ? 1 : 0;
+}